@@ -28,6 +28,7 @@ killall Karabiner-DriverKit-VirtualHIDDeviceClient
 rm -rf '/Applications/.Karabiner-VirtualHIDDevice-Manager.app'
 rm -rf '/Library/Application Support/org.pqrs/Karabiner-DriverKit-VirtualHIDDevice'
 
+rm -f '/Library/Application Support/org.pqrs/tmp/rootonly/karabiner_virtual_hid_device_service.sock'
 rm -f '/Library/Application Support/org.pqrs/tmp/rootonly/virtual_hid_device_service_server.*'
 rm -rf '/Library/Application Support/org.pqrs/tmp/rootonly/vhidd_server'
 rmdir '/Library/Application Support/org.pqrs/tmp/rootonly'
@@ -7,7 +7,15 @@
 #include "client_protocol_version.hpp"
 #include "driver_version.hpp"
 #include "virtual_hid_device_service/client.hpp"
+#include "virtual_hid_device_service/client_options.hpp"
 #include "virtual_hid_device_service/constants.hpp"
+#include "virtual_hid_device_service/duplicate_report_filter.hpp"
 #include "virtual_hid_device_service/parameters.hpp"
+#include "virtual_hid_device_service/report_batch.hpp"
+#include "virtual_hid_device_service/report_coalescing.hpp"
+#include "virtual_hid_device_service/report_journal.hpp"
+#include "virtual_hid_device_service/report_ring.hpp"
 #include "virtual_hid_device_service/request.hpp"
+#include "virtual_hid_device_service/request_buffer.hpp"
 #include "virtual_hid_device_service/response.hpp"
+#include "virtual_hid_device_service/statistics.hpp"
@@ -4,17 +4,27 @@
 // Distributed under the Boost Software License, Version 1.0.
 // (See https://www.boost.org/LICENSE_1_0.txt)
 
+#include "client_options.hpp"
 #include "constants.hpp"
+#include "duplicate_report_filter.hpp"
 #include "parameters.hpp"
+#include "report_batch.hpp"
+#include "report_coalescing.hpp"
+#include "report_ring.hpp"
 #include "request.hpp"
+#include "request_buffer.hpp"
 #include "response.hpp"
-#include <cstring>
+#include "statistics.hpp"
+#include <algorithm>
+#include <atomic>
 #include <pqrs/dispatcher.hpp>
 #include <pqrs/gsl.hpp>
 #include <pqrs/hid.hpp>
 #include <pqrs/unix_domain_stream.hpp>
 #include <ranges>
-#include <type_traits>
+#include <span>
+#include <string>
+#include <unistd.h>
 
 namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
 class client final : public dispatcher::extra::dispatcher_client {
@@ -31,11 +41,17 @@ public:
   nod::signal<void(bool)> driver_version_mismatched;
   nod::signal<void(bool)> virtual_hid_keyboard_ready;
   nod::signal<void(bool)> virtual_hid_pointing_ready;
+  nod::signal<void(const statistics&)> statistics_received;
 
   // Methods
 
   client()
-      : dispatcher_client() {
+      : client(client_options()) {
+  }
+
+  explicit client(const client_options& options)
+      : dispatcher_client(),
+        options_(options) {
   }
 
   ~client() override {
@@ -77,15 +93,27 @@ public:
 
     last_virtual_hid_keyboard_parameters_ = parameters;
 
+    enqueue_to_dispatcher([this] {
+      duplicate_report_filter_.clear_keyboard_reports();
+    });
+
     async_request(make_request_buffer(request::virtual_hid_keyboard_initialize,
                                       parameters));
   }
 
   void async_virtual_hid_keyboard_terminate() {
+    enqueue_to_dispatcher([this] {
+      duplicate_report_filter_.clear_keyboard_reports();
+    });
+
     async_request(make_request_buffer(request::virtual_hid_keyboard_terminate));
   }
 
   void async_virtual_hid_keyboard_reset() {
+    enqueue_to_dispatcher([this] {
+      duplicate_report_filter_.clear_keyboard_reports();
+    });
+
     async_request(make_request_buffer(request::virtual_hid_keyboard_reset));
   }
 
@@ -96,45 +124,99 @@ public:
       }
     }
 
+    enqueue_to_dispatcher([this] {
+      duplicate_report_filter_.clear_pointing_reports();
+    });
+
     async_request(make_request_buffer(request::virtual_hid_pointing_initialize));
   }
 
   void async_virtual_hid_pointing_terminate() {
+    enqueue_to_dispatcher([this] {
+      duplicate_report_filter_.clear_pointing_reports();
+    });
+
     async_request(make_request_buffer(request::virtual_hid_pointing_terminate));
   }
 
   void async_virtual_hid_pointing_reset() {
+    enqueue_to_dispatcher([this] {
+      duplicate_report_filter_.clear_pointing_reports();
+    });
+
     async_request(make_request_buffer(request::virtual_hid_pointing_reset));
   }
 
+  // Query the report counters of this client in the daemon.
+  // The result is delivered via `statistics_received`.
+  void async_get_statistics() {
+    async_request(make_request_buffer(request::get_statistics));
+  }
+
   void async_post_report(const virtual_hid_device_driver::hid_report::keyboard_input& report) {
-    async_request(make_request_buffer(request::post_keyboard_input_report,
-                                      report));
+    enqueue_to_dispatcher([this, report] {
+      post_report(report);
+    });
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::consumer_input& report) {
-    async_request(make_request_buffer(request::post_consumer_input_report,
-                                      report));
+    enqueue_to_dispatcher([this, report] {
+      post_report(report);
+    });
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input& report) {
-    async_request(make_request_buffer(request::post_apple_vendor_keyboard_input_report,
-                                      report));
+    enqueue_to_dispatcher([this, report] {
+      post_report(report);
+    });
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::apple_vendor_top_case_input& report) {
-    async_request(make_request_buffer(request::post_apple_vendor_top_case_input_report,
-                                      report));
+    enqueue_to_dispatcher([this, report] {
+      post_report(report);
+    });
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::generic_desktop_input& report) {
-    async_request(make_request_buffer(request::post_generic_desktop_input_report,
-                                      report));
+    enqueue_to_dispatcher([this, report] {
+      post_report(report);
+    });
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::pointing_input& report) {
-    async_request(make_request_buffer(request::post_pointing_input_report,
-                                      report));
+    enqueue_to_dispatcher([this, report] {
+      post_report(report);
+    });
+  }
+
+  // Post several reports in order with `request::post_report_batch`.
+  // Reports are packed into as few messages as `constants::unix_domain_stream_max_message_size` allows.
+  void async_post_reports(std::span<const input_report> reports) {
+    enqueue_to_dispatcher([this, reports = std::vector<input_report>(std::begin(reports), std::end(reports))] mutable {
+      if (options_.suppress_duplicate_reports) {
+        std::erase_if(reports, [this](auto&& r) {
+          return std::visit(
+              [this](auto&& report) {
+                return duplicate_report_filter_.suppress(report);
+              },
+              r);
+        });
+      }
+
+      // Reports after the first report which cannot be pushed are sent through the socket to keep the order.
+      auto it = std::ranges::find_if_not(reports, [this](auto&& r) {
+        return std::visit(
+            [this](auto&& report) {
+              return push_to_report_ring(report);
+            },
+            r);
+      });
+
+      for (auto&& buffer : make_report_batch_buffers(std::span<const input_report>(it, std::end(reports)),
+                                                     constants::unix_domain_stream_max_message_size)) {
+        send(std::move(buffer));
+      }
+    });
   }
 
 private:
@@ -146,24 +228,49 @@ private:
     virtual_hid_pointing_ready(false);
 
     last_virtual_hid_keyboard_parameters_ = std::nullopt;
+
+    duplicate_report_filter_.clear();
+
+    report_ring_ = nullptr;
+    report_ring_opened_ = false;
   }
 
   void create_client() {
+    pqrs::unix_domain_stream::common_options::initialization_parameters common_parameters{
+        .max_message_size = constants::unix_domain_stream_max_message_size,
+    };
+
+    if (options_.coalesce_reports) {
+      // This function is called in the io thread of `client_`.
+      set_coalesce_user_data(common_parameters, [this](auto queued_data, auto data) {
+        if (coalesce_post_report(queued_data, data)) {
+          ++coalesced_message_count_;
+          return true;
+        }
+        return false;
+      });
+    }
+
     auto options = pqrs::unix_domain_stream::client_options(
-        {
-            .max_message_size = constants::unix_domain_stream_max_message_size,
-        },
+        common_parameters,
         {
             .reconnect_interval = std::chrono::milliseconds(1000),
         });
 
     client_ = std::make_unique<unix_domain_stream::client>(weak_dispatcher_,
-                                                           constants::get_server_socket_file_path(),
+                                                           options_.server_socket_file_path,
                                                            options);
 
     client_->connected.connect([this](auto&&) {
       enqueue_to_dispatcher([this] {
+        sent_message_count_ = 0;
+        coalesced_message_count_ = 0;
+
         connected();
+
+        if (options_.report_ring) {
+          open_report_ring();
+        }
       });
     });
 
@@ -211,6 +318,16 @@ private:
     }
 
     const auto& response_buffer = *buffer;
+
+    if (response_buffer.front() == std::to_underlying(response::statistics)) {
+      if (auto value = parse_statistics_response(response_buffer)) {
+        statistics_received(*value);
+      } else {
+        warning_reported("virtual_hid_device_service::client: statistics buffer size is invalid");
+      }
+      return;
+    }
+
     if (response_buffer.size() % 2 != 0) {
       warning_reported("virtual_hid_device_service::client: message buffer size is invalid");
       return;
@@ -237,15 +354,29 @@ private:
           break;
 
         case response::virtual_hid_keyboard_ready:
+          // Reports posted before the readiness change may have been dropped by the daemon,
+          // so they must not suppress the following reports.
+          if (last_virtual_hid_keyboard_ready_ != static_cast<bool>(value)) {
+            duplicate_report_filter_.clear_keyboard_reports();
+          }
           last_virtual_hid_keyboard_ready_ = value;
           virtual_hid_keyboard_ready(value);
           break;
 
         case response::virtual_hid_pointing_ready:
+          // Reports posted before the readiness change may have been dropped by the daemon,
+          // so they must not suppress the following reports.
+          if (last_virtual_hid_pointing_ready_ != static_cast<bool>(value)) {
+            duplicate_report_filter_.clear_pointing_reports();
+          }
           last_virtual_hid_pointing_ready_ = value;
           virtual_hid_pointing_ready(value);
           break;
 
+        case response::report_ring_opened:
+          report_ring_opened_ = value && report_ring_;
+          break;
+
         default:
           warning_reported("virtual_hid_device_service::client: unknown message");
           break;
@@ -253,54 +384,182 @@ private:
     }
   }
 
-  void async_request(pqrs::not_null_shared_ptr_t<std::vector<uint8_t>> request_buffer) {
-    enqueue_to_dispatcher([this, request_buffer] {
-      if (client_) {
-        client_->async_request(
-            *request_buffer,
-            [this](auto&& error_code, auto&& response_buffer) {
-              enqueue_to_dispatcher([this, error_code, response_buffer] {
-                if (error_code) {
-                  error_occurred(error_code);
-                  return;
-                }
-
-                handle_message(response_buffer);
-              });
-            });
-      }
+  template <size_t DataSize>
+  void async_request(const request_buffer<DataSize>& buffer) {
+    enqueue_to_dispatcher([this, buffer] {
+      send_request(buffer);
     });
   }
 
-  pqrs::not_null_shared_ptr_t<std::vector<uint8_t>> make_request_buffer(request request_type) const {
-    pqrs::not_null_shared_ptr_t<std::vector<uint8_t>> buffer(std::make_shared<std::vector<uint8_t>>());
+  // This method is executed in the dispatcher thread.
+  template <typename T>
+  void post_report(const T& report) {
+    if (options_.suppress_duplicate_reports &&
+        duplicate_report_filter_.suppress(report)) {
+      return;
+    }
 
-    append_data(*buffer, client_protocol_version::embedded_client_protocol_version);
-    append_data(*buffer, request_type);
+    if (push_to_report_ring(report)) {
+      return;
+    }
 
-    return buffer;
+    send(make_request_buffer(post_report_request<T>(),
+                             report));
   }
 
-  template <typename T>
-  pqrs::not_null_shared_ptr_t<std::vector<uint8_t>> make_request_buffer(request request_type, const T& data) const {
-    auto buffer = make_request_buffer(request_type);
+  // This method is executed in the dispatcher thread.
+  template <size_t DataSize>
+  void send(const request_buffer<DataSize>& buffer) {
+    if (client_) {
+      send(make_send_buffer(buffer));
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  //
+  // Post report requests are sent as one-way messages.
+  // The server does not respond to them, so there is no pending request or response per report.
+  // Connection errors are reported asynchronously via `error_occurred` and `closed`.
+  void send(std::vector<uint8_t>&& buffer) {
+    if (client_) {
+      ++sent_message_count_;
+      client_->async_send(std::move(buffer));
+    }
+  }
 
-    append_data(*buffer, data);
+  // This method is executed in the dispatcher thread.
+  //
+  // Copy `buffer` into a buffer from the send buffer pool of `client_`,
+  // which reuses the memory of sent messages instead of allocating a vector per message.
+  // `client_` must not be nullptr.
+  template <size_t DataSize>
+  std::vector<uint8_t> make_send_buffer(const request_buffer<DataSize>& buffer) {
+    auto result = acquire_send_buffer(*client_, buffer.size());
+    std::ranges::copy(buffer, std::begin(result));
+    return result;
+  }
 
-    return buffer;
+  //
+  // The released pqrs::unix_domain_stream (v3.0.0) has neither `coalesce_user_data` nor `client::acquire_send_buffer`.
+  // They are used only when the pqrs::unix_domain_stream in the header search paths has them,
+  // so that client applications can build this client with the released version.
+  //
+
+  // `coalesce_reports` has no effect without `coalesce_user_data`.
+  template <typename Parameters, typename Function>
+  static void set_coalesce_user_data(Parameters& parameters, Function&& function) {
+    if constexpr (requires { parameters.coalesce_user_data = function; }) {
+      parameters.coalesce_user_data = std::forward<Function>(function);
+    }
   }
 
+  // A vector is allocated for each message without `acquire_send_buffer`.
+  template <typename Client>
+  static std::vector<uint8_t> acquire_send_buffer(Client& client, size_t size) {
+    if constexpr (requires { client.acquire_send_buffer(size); }) {
+      return client.acquire_send_buffer(size);
+    } else {
+      return std::vector<uint8_t>(size);
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void open_report_ring() {
+    static std::atomic<uint32_t> counter;
+    auto name = "/pqrs.vhid." + std::to_string(getpid()) + "." + std::to_string(counter++);
+
+    report_ring_ = report_ring::create(name);
+    if (!report_ring_) {
+      warning_reported("virtual_hid_device_service::client: report_ring::create error: " + name);
+      return;
+    }
+
+    send_request(make_request_buffer(request::report_ring_open,
+                                     report_ring_->get_name()),
+                 [this, name = report_ring_->get_name()] {
+                   // The server has opened the shared memory, or does not support the ring.
+                   if (report_ring_ &&
+                       report_ring_->get_name() == name) {
+                     report_ring_->unlink();
+
+                     if (!report_ring_opened_) {
+                       report_ring_ = nullptr;
+                     }
+                   }
+                 });
+  }
+
+  // This method is executed in the dispatcher thread.
+  //
+  // Returns true if the report is pushed into the report ring.
+  // The ring is used only while all messages sent through the socket have been handled by the server,
+  // since the server drains the ring before handling each message.
+  // Messages merged by `coalesce_post_report` are not handled as separate messages.
   template <typename T>
-  void append_data(std::vector<uint8_t>& buffer, const T& data) const {
-    static_assert(std::is_trivially_copyable_v<T>);
+  bool push_to_report_ring(const T& report) {
+    if (!report_ring_opened_) {
+      return false;
+    }
+
+    // Load the handled count first.
+    // Messages are merged only before the merged frame is written,
+    // so the merges of all handled messages are already counted when the handled count is loaded.
+    auto handled_message_count = report_ring_->get_handled_message_count();
+    if (handled_message_count + coalesced_message_count_ != sent_message_count_) {
+      return false;
+    }
+
+    switch (report_ring_->push(report)) {
+      case report_ring::push_result::full:
+        return false;
+
+      case report_ring::push_result::pushed:
+        return true;
 
-    auto size = buffer.size();
-    buffer.resize(size + sizeof(data));
-    std::memcpy(buffer.data() + size,
-                std::addressof(data),
-                sizeof(data));
+      case report_ring::push_result::doorbell_required:
+        if (client_) {
+          client_->async_send(make_send_buffer(make_request_buffer(request::report_ring_doorbell)));
+        }
+        return true;
+    }
+
+    return false;
+  }
+
+  // This method is executed in the dispatcher thread.
+  template <size_t DataSize>
+  void send_request(const request_buffer<DataSize>& buffer,
+                    std::function<void()> handled = nullptr) {
+    if (client_) {
+      ++sent_message_count_;
+      client_->async_request(
+          make_send_buffer(buffer),
+          [this, handled](auto&& error_code, auto&& response_buffer) {
+            enqueue_to_dispatcher([this, handled, error_code, response_buffer] {
+              if (error_code) {
+                error_occurred(error_code);
+              } else {
+                handle_message(response_buffer);
+              }
+
+              if (handled) {
+                handled();
+              }
+            });
+          });
+    }
   }
 
+  client_options options_;
+  duplicate_report_filter duplicate_report_filter_;
+
+  std::unique_ptr<report_ring> report_ring_;
+  bool report_ring_opened_ = false;
+
+  // The number of messages sent through the socket in the current connection except `request::report_ring_doorbell`.
+  uint64_t sent_message_count_ = 0;
+  // The number of messages in `sent_message_count_` which are merged into the preceding message by `coalesce_post_report`.
+  std::atomic<uint64_t> coalesced_message_count_ = 0;
   std::unique_ptr<unix_domain_stream::client> client_;
 
   std::optional<bool> last_virtual_hid_keyboard_ready_;
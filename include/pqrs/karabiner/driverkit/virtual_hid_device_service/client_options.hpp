@@ -0,0 +1,31 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "constants.hpp"
+#include <filesystem>
+
+namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
+struct client_options final {
+  // Merge post report requests which are still waiting in the send queue when the daemon or socket stalls.
+  // See `coalesce_post_report` for the policy.
+  // It requires pqrs::unix_domain_stream with `coalesce_user_data` (vendor/local), and has no effect with the released v3.0.0.
+  bool coalesce_reports = false;
+
+  // Drop reports which are the same as the last posted report of the same type.
+  // Pointing reports with movement (non-zero x, y or wheel) are always posted since each of them is a relative movement.
+  // The last reports are forgotten when the connection is closed or the virtual device is initialized, reset, terminated or its readiness changes.
+  bool suppress_duplicate_reports = false;
+
+  // Post reports through `report_ring` in shared memory instead of the socket.
+  // The ring is negotiated on each connection, and reports are sent through the socket
+  // when the daemon does not support the ring or the ring is full.
+  bool report_ring = false;
+
+  // The socket of the daemon.
+  // Change it only to connect to a daemon which is started with another socket path, such as tests and benchmarks.
+  std::filesystem::path server_socket_file_path = constants::get_server_socket_file_path();
+};
+} // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
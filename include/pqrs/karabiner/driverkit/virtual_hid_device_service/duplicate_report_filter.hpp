@@ -0,0 +1,78 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../virtual_hid_device_driver.hpp"
+#include <optional>
+#include <tuple>
+
+namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
+// `duplicate_report_filter` keeps the last posted report for each report type
+// in order to drop reports which do not change the device state.
+//
+// Keyboard, consumer, apple vendor and generic desktop reports carry absolute state, so a repeated report is dropped.
+// Pointing reports carry relative movement, so only a repeated report without movement (the same buttons and zero deltas) is dropped.
+//
+// The cached reports have to be cleared when the device state is changed by other ways (reconnect, reset, etc.).
+class duplicate_report_filter final {
+public:
+  // Returns true if `report` is the same as the last posted report of the same type.
+  // Otherwise, `report` is stored as the last posted report and false is returned.
+  template <typename T>
+  bool suppress(const T& report) {
+    auto& last_report = std::get<std::optional<T>>(last_reports_);
+
+    if (last_report == report &&
+        !has_movement(report)) {
+      return true;
+    }
+
+    last_report = report;
+    return false;
+  }
+
+  void clear_keyboard_reports() {
+    using namespace virtual_hid_device_driver::hid_report;
+
+    std::get<std::optional<keyboard_input>>(last_reports_) = std::nullopt;
+    std::get<std::optional<consumer_input>>(last_reports_) = std::nullopt;
+    std::get<std::optional<apple_vendor_keyboard_input>>(last_reports_) = std::nullopt;
+    std::get<std::optional<apple_vendor_top_case_input>>(last_reports_) = std::nullopt;
+    std::get<std::optional<generic_desktop_input>>(last_reports_) = std::nullopt;
+  }
+
+  void clear_pointing_reports() {
+    using namespace virtual_hid_device_driver::hid_report;
+
+    std::get<std::optional<pointing_input>>(last_reports_) = std::nullopt;
+  }
+
+  void clear() {
+    clear_keyboard_reports();
+    clear_pointing_reports();
+  }
+
+private:
+  template <typename T>
+  static bool has_movement(const T&) {
+    return false;
+  }
+
+  static bool has_movement(const virtual_hid_device_driver::hid_report::pointing_input& report) {
+    return report.x != 0 ||
+           report.y != 0 ||
+           report.vertical_wheel != 0 ||
+           report.horizontal_wheel != 0;
+  }
+
+  std::tuple<std::optional<virtual_hid_device_driver::hid_report::keyboard_input>,
+             std::optional<virtual_hid_device_driver::hid_report::consumer_input>,
+             std::optional<virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input>,
+             std::optional<virtual_hid_device_driver::hid_report::apple_vendor_top_case_input>,
+             std::optional<virtual_hid_device_driver::hid_report::generic_desktop_input>,
+             std::optional<virtual_hid_device_driver::hid_report::pointing_input>>
+      last_reports_;
+};
+} // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
@@ -0,0 +1,128 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../client_protocol_version.hpp"
+#include "../virtual_hid_device_driver.hpp"
+#include "request.hpp"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
+using input_report = std::variant<virtual_hid_device_driver::hid_report::keyboard_input,
+                                  virtual_hid_device_driver::hid_report::consumer_input,
+                                  virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input,
+                                  virtual_hid_device_driver::hid_report::apple_vendor_top_case_input,
+                                  virtual_hid_device_driver::hid_report::generic_desktop_input,
+                                  virtual_hid_device_driver::hid_report::pointing_input>;
+
+// The largest report size in `input_report`.
+constexpr size_t max_input_report_size = []<size_t... I>(std::index_sequence<I...>) {
+  return std::max({sizeof(std::variant_alternative_t<I, input_report>)...});
+}(std::make_index_sequence<std::variant_size_v<input_report>>());
+
+template <typename T>
+constexpr request post_report_request() {
+  using namespace virtual_hid_device_driver::hid_report;
+
+  if constexpr (std::is_same_v<T, keyboard_input>) {
+    return request::post_keyboard_input_report;
+  } else if constexpr (std::is_same_v<T, consumer_input>) {
+    return request::post_consumer_input_report;
+  } else if constexpr (std::is_same_v<T, apple_vendor_keyboard_input>) {
+    return request::post_apple_vendor_keyboard_input_report;
+  } else if constexpr (std::is_same_v<T, apple_vendor_top_case_input>) {
+    return request::post_apple_vendor_top_case_input_report;
+  } else if constexpr (std::is_same_v<T, generic_desktop_input>) {
+    return request::post_generic_desktop_input_report;
+  } else {
+    static_assert(std::is_same_v<T, pointing_input>);
+    return request::post_pointing_input_report;
+  }
+}
+
+// Returns the report size of post report requests, or std::nullopt for other requests.
+constexpr std::optional<size_t> post_report_size(request request_type) {
+  using namespace virtual_hid_device_driver::hid_report;
+
+  switch (request_type) {
+    case request::post_keyboard_input_report:
+      return sizeof(keyboard_input);
+    case request::post_consumer_input_report:
+      return sizeof(consumer_input);
+    case request::post_apple_vendor_keyboard_input_report:
+      return sizeof(apple_vendor_keyboard_input);
+    case request::post_apple_vendor_top_case_input_report:
+      return sizeof(apple_vendor_top_case_input);
+    case request::post_generic_desktop_input_report:
+      return sizeof(generic_desktop_input);
+    case request::post_pointing_input_report:
+      return sizeof(pointing_input);
+    default:
+      return std::nullopt;
+  }
+}
+
+// Encodes reports into `request::post_report_batch` payloads.
+// Reports are split into several payloads so that each payload fits in `max_message_size`.
+//
+// Layout:
+//   buffer[0]: client_protocol_version[0]
+//   buffer[1]: client_protocol_version[1]
+//   buffer[2]: request::post_report_batch
+//   buffer[3...]: entries
+//
+// Entry layout:
+//   entry[0]: request::post_*_report
+//   entry[1...]: report (the size is determined by the request)
+inline std::vector<std::vector<uint8_t>> make_report_batch_buffers(std::span<const input_report> reports,
+                                                                   size_t max_message_size) {
+  constexpr size_t header_size = sizeof(client_protocol_version::value_t) + sizeof(request);
+
+  std::vector<std::vector<uint8_t>> buffers;
+
+  auto append_data = [](std::vector<uint8_t>& buffer, const auto& data) {
+    static_assert(std::is_trivially_copyable_v<std::decay_t<decltype(data)>>);
+
+    auto size = buffer.size();
+    buffer.resize(size + sizeof(data));
+    std::memcpy(buffer.data() + size,
+                std::addressof(data),
+                sizeof(data));
+  };
+
+  for (const auto& r : reports) {
+    std::visit(
+        [&](const auto& report) {
+          constexpr auto request_type = post_report_request<std::decay_t<decltype(report)>>();
+          constexpr auto entry_size = sizeof(request_type) + sizeof(report);
+
+          if (header_size + entry_size > max_message_size) {
+            return;
+          }
+
+          if (buffers.empty() ||
+              buffers.back().size() + entry_size > max_message_size) {
+            auto& buffer = buffers.emplace_back();
+            buffer.reserve(max_message_size);
+            append_data(buffer, client_protocol_version::embedded_client_protocol_version);
+            append_data(buffer, request::post_report_batch);
+          }
+
+          append_data(buffers.back(), request_type);
+          append_data(buffers.back(), report);
+        },
+        r);
+  }
+
+  return buffers;
+}
+} // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
@@ -0,0 +1,76 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../client_protocol_version.hpp"
+#include "../virtual_hid_device_driver.hpp"
+#include "report_batch.hpp"
+#include "request.hpp"
+#include <algorithm>
+#include <cstring>
+#include <span>
+
+namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
+namespace impl {
+// Adds relative values which are stored as int8_t in `pointing_input`.
+constexpr uint8_t saturating_add_int8(uint8_t a, uint8_t b) {
+  auto value = static_cast<int>(static_cast<int8_t>(a)) + static_cast<int>(static_cast<int8_t>(b));
+  return static_cast<uint8_t>(static_cast<int8_t>(std::clamp(value, -128, 127)));
+}
+} // namespace impl
+
+// Merges a post report payload into the queued post report payload which has not been sent yet.
+// This is used as `unix_domain_stream::common_options::coalesce_user_data`.
+//
+// - pointing_input:
+//   Relative values (x, y, vertical_wheel, horizontal_wheel) are summed, saturating at the int8 range.
+//   Reports are merged only when the buttons are not changed, so button transitions are preserved.
+// - Other reports (keyboard_input, consumer_input, etc.):
+//   These reports hold the latest state.
+//   The queued report is replaced only when no transition is lost, that is, when the new report has the same state.
+//
+// Returns true if `data` was merged into `queued_data`.
+inline bool coalesce_post_report(std::span<uint8_t> queued_data,
+                                 std::span<const uint8_t> data) {
+  using namespace virtual_hid_device_driver::hid_report;
+
+  constexpr size_t header_size = sizeof(client_protocol_version::value_t) + sizeof(request);
+
+  if (queued_data.size() != data.size() ||
+      data.size() < header_size ||
+      !std::equal(std::begin(data), std::begin(data) + header_size, std::begin(queued_data))) {
+    return false;
+  }
+
+  auto request_type = static_cast<request>(data[header_size - 1]);
+  auto report_size = post_report_size(request_type);
+  if (!report_size ||
+      header_size + *report_size != data.size()) {
+    return false;
+  }
+
+  if (request_type == request::post_pointing_input_report) {
+    pointing_input queued_report;
+    pointing_input report;
+    std::memcpy(&queued_report, queued_data.data() + header_size, sizeof(queued_report));
+    std::memcpy(&report, data.data() + header_size, sizeof(report));
+
+    if (queued_report.buttons.get_raw_value() != report.buttons.get_raw_value()) {
+      return false;
+    }
+
+    queued_report.x = impl::saturating_add_int8(queued_report.x, report.x);
+    queued_report.y = impl::saturating_add_int8(queued_report.y, report.y);
+    queued_report.vertical_wheel = impl::saturating_add_int8(queued_report.vertical_wheel, report.vertical_wheel);
+    queued_report.horizontal_wheel = impl::saturating_add_int8(queued_report.horizontal_wheel, report.horizontal_wheel);
+
+    std::memcpy(queued_data.data() + header_size, &queued_report, sizeof(queued_report));
+    return true;
+  }
+
+  // The queued report already holds the same state.
+  return std::equal(std::begin(data), std::end(data), std::begin(queued_data));
+}
+} // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
@@ -0,0 +1,237 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "report_batch.hpp"
+#include "request.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
+// `report_journal` is a flight recorder which keeps the latest forwarded reports in a memory-mapped file.
+//
+// Records are written into fixed-size slots of a ring, so writing a record does neither allocation nor formatting.
+// The file contents survive a crash of the writer process, and `read` decodes them afterwards.
+//
+// Each record has a sequence number which is written after the other fields.
+// A record whose sequence number is 0 is empty or was being written.
+//
+// The writer is not thread-safe.
+class report_journal final {
+public:
+  static constexpr uint32_t magic = 0x76686a72; // "vhjr"
+  static constexpr uint32_t version = 1;
+
+  struct entry final {
+    uint64_t sequence;
+    // steady_clock time in nanoseconds.
+    uint64_t timestamp;
+    // system_clock time in nanoseconds since the epoch, which is estimated from `timestamp`.
+    uint64_t system_timestamp;
+    uint64_t peer_id;
+    request request_type;
+    std::vector<uint8_t> payload;
+  };
+
+  report_journal(const report_journal&) = delete;
+
+  ~report_journal() {
+    munmap(header_, file_size(record_count_));
+  }
+
+  // Create a new journal file for writing.
+  // An existing file at `path` is kept as `get_previous_file_path(path)` so that the records before a restart are not lost.
+  // Returns nullptr if the file cannot be created.
+  static std::unique_ptr<report_journal> create(const std::filesystem::path& path,
+                                                uint32_t record_count) {
+    if (record_count == 0) {
+      return nullptr;
+    }
+
+    std::error_code error_code;
+    if (std::filesystem::file_size(path, error_code) > 0) {
+      std::filesystem::rename(path, get_previous_file_path(path), error_code);
+    }
+    std::filesystem::remove(path, error_code);
+
+    auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+      return nullptr;
+    }
+
+    auto size = file_size(record_count);
+
+    void* address = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+      address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (address == MAP_FAILED) {
+      return nullptr;
+    }
+
+    // The file is zero-filled by ftruncate.
+    auto h = new (address) header{
+        .magic = magic,
+        .version = version,
+        .record_size = sizeof(record),
+        .record_count = record_count,
+        .steady_clock_origin = to_nanoseconds(std::chrono::steady_clock::now().time_since_epoch()),
+        .system_clock_origin = to_nanoseconds(std::chrono::system_clock::now().time_since_epoch()),
+    };
+    auto records = reinterpret_cast<record*>(static_cast<uint8_t*>(address) + sizeof(header));
+    std::uninitialized_default_construct_n(records, record_count);
+
+    return std::unique_ptr<report_journal>(new report_journal(h, records, record_count));
+  }
+
+  static std::filesystem::path get_previous_file_path(const std::filesystem::path& path) {
+    auto result = path;
+    result += ".previous";
+    return result;
+  }
+
+  void write(uint64_t peer_id,
+             request request_type,
+             std::span<const uint8_t> payload,
+             std::chrono::steady_clock::time_point timestamp) {
+    auto sequence = ++last_sequence_;
+    auto& r = records_[(sequence - 1) % record_count_];
+
+    std::atomic_ref<uint64_t>(r.sequence).store(0, std::memory_order_relaxed);
+    std::atomic_signal_fence(std::memory_order_release);
+
+    r.timestamp = to_nanoseconds(timestamp.time_since_epoch());
+    r.peer_id = peer_id;
+    r.request_type = request_type;
+    r.payload_size = static_cast<uint8_t>(std::min(payload.size(), r.payload.size()));
+    std::memcpy(r.payload.data(), payload.data(), r.payload_size);
+
+    std::atomic_ref<uint64_t>(r.sequence).store(sequence, std::memory_order_release);
+  }
+
+  // Returns the records in the order they were written, or std::nullopt if the file is not a journal.
+  static std::optional<std::vector<entry>> read(const std::filesystem::path& path) {
+    std::vector<uint8_t> buffer;
+
+    {
+      auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        return std::nullopt;
+      }
+
+      struct stat st;
+      if (fstat(fd, &st) == 0 &&
+          static_cast<size_t>(st.st_size) >= sizeof(header)) {
+        buffer.resize(st.st_size);
+        if (pread(fd, buffer.data(), buffer.size(), 0) != static_cast<ssize_t>(buffer.size())) {
+          buffer.clear();
+        }
+      }
+      close(fd);
+    }
+
+    if (buffer.empty()) {
+      return std::nullopt;
+    }
+
+    header h;
+    std::memcpy(&h, buffer.data(), sizeof(h));
+    if (h.magic != magic ||
+        h.version != version ||
+        h.record_size != sizeof(record) ||
+        h.record_count == 0 ||
+        buffer.size() < file_size(h.record_count)) {
+      return std::nullopt;
+    }
+
+    std::vector<entry> entries;
+
+    for (uint32_t i = 0; i < h.record_count; ++i) {
+      record r;
+      std::memcpy(&r, buffer.data() + sizeof(header) + i * sizeof(record), sizeof(r));
+
+      if (r.sequence == 0) {
+        continue;
+      }
+
+      entries.push_back(entry{
+          .sequence = r.sequence,
+          .timestamp = r.timestamp,
+          .system_timestamp = h.system_clock_origin + (r.timestamp - h.steady_clock_origin),
+          .peer_id = r.peer_id,
+          .request_type = r.request_type,
+          .payload = std::vector<uint8_t>(std::begin(r.payload),
+                                          std::begin(r.payload) + std::min<size_t>(r.payload_size, r.payload.size())),
+      });
+    }
+
+    std::ranges::sort(entries, {}, &entry::sequence);
+
+    return entries;
+  }
+
+private:
+  struct header final {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t record_count;
+    // The clocks at the file creation, which are used to convert steady_clock timestamps into system_clock.
+    uint64_t steady_clock_origin;
+    uint64_t system_clock_origin;
+  };
+
+  struct record final {
+    alignas(8) uint64_t sequence;
+    uint64_t timestamp;
+    uint64_t peer_id;
+    request request_type;
+    uint8_t payload_size;
+    std::array<uint8_t, max_input_report_size> payload;
+  };
+
+  // `record_count` records follow the header.
+  static_assert(sizeof(header) % alignof(record) == 0);
+  static_assert(std::is_trivially_copyable_v<record>);
+  static_assert(std::atomic_ref<uint64_t>::is_always_lock_free);
+
+  static size_t file_size(uint32_t record_count) {
+    return sizeof(header) + sizeof(record) * record_count;
+  }
+
+  static uint64_t to_nanoseconds(std::chrono::nanoseconds value) {
+    return static_cast<uint64_t>(value.count());
+  }
+
+  report_journal(header* header,
+                 record* records,
+                 uint32_t record_count)
+      : header_(header),
+        records_(records),
+        record_count_(record_count) {
+  }
+
+  header* header_;
+  record* records_;
+  uint32_t record_count_;
+  uint64_t last_sequence_ = 0;
+};
+} // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
@@ -0,0 +1,285 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "report_batch.hpp"
+#include "request.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
+// `report_ring` is a single-producer single-consumer ring of fixed-size report slots in POSIX shared memory.
+// The client creates the ring and pushes reports; virtual_hid_device_service_server opens it and drains reports.
+//
+// The unix_domain_stream connection remains the control channel.
+// The consumer arms the doorbell after it drains the ring, and the producer sends `request::report_ring_doorbell`
+// through the connection only when the doorbell is armed. Thus, a busy consumer is not woken up for each report.
+//
+// The consumer must not trust the shared memory contents since the producer is another process.
+class report_ring final {
+public:
+  // The name size limit of shm_open on macOS is 31 (PSHMNAMLEN).
+  using name_t = std::array<char, 32>;
+
+  static constexpr uint32_t magic = 0x76687272; // "vhrr"
+  static constexpr uint32_t slot_count = 256;
+
+  enum class push_result {
+    full,
+    pushed,
+    doorbell_required,
+  };
+
+  enum class drain_result {
+    // The shared state is broken.
+    broken,
+    // The ring is drained and the doorbell is armed.
+    drained,
+    // Reports were pushed while the ring was drained, and the producer does not ring the doorbell for them.
+    // The consumer has to call `drain` again.
+    pending,
+  };
+
+  report_ring(const report_ring&) = delete;
+
+  ~report_ring() {
+    unlink();
+
+    if (layout_) {
+      munmap(layout_, sizeof(layout));
+    }
+  }
+
+  // Create a new shared memory ring as the producer.
+  // Returns nullptr if the shared memory cannot be created.
+  static std::unique_ptr<report_ring> create(std::string_view name) {
+    name_t n{};
+    if (name.size() >= n.size()) {
+      return nullptr;
+    }
+    std::ranges::copy(name, std::begin(n));
+
+    auto fd = shm_open(n.data(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+      return nullptr;
+    }
+
+    void* address = MAP_FAILED;
+    if (ftruncate(fd, sizeof(layout)) == 0) {
+      address = mmap(nullptr, sizeof(layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (address == MAP_FAILED) {
+      shm_unlink(n.data());
+      return nullptr;
+    }
+
+    auto l = new (address) layout{};
+    l->header.magic = magic;
+    l->header.slot_count = slot_count;
+    l->header.slot_size = sizeof(slot);
+    l->header.doorbell_armed.store(1);
+
+    return std::unique_ptr<report_ring>(new report_ring(n, l, true));
+  }
+
+  // Open the ring which is created by the producer.
+  // Returns nullptr if the shared memory is not owned by `owner_uid` or the layout does not match.
+  static std::unique_ptr<report_ring> open(const name_t& name,
+                                           uid_t owner_uid) {
+    if (std::ranges::find(name, '\0') == std::end(name) ||
+        name[0] != '/') {
+      return nullptr;
+    }
+
+    auto fd = shm_open(name.data(), O_RDWR, 0);
+    if (fd < 0) {
+      return nullptr;
+    }
+
+    void* address = MAP_FAILED;
+    struct stat st;
+    if (fstat(fd, &st) == 0 &&
+        st.st_uid == owner_uid &&
+        static_cast<size_t>(st.st_size) >= sizeof(layout)) {
+      address = mmap(nullptr, sizeof(layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (address == MAP_FAILED) {
+      return nullptr;
+    }
+
+    auto l = std::launder(static_cast<layout*>(address));
+    if (l->header.magic != magic ||
+        l->header.slot_count != slot_count ||
+        l->header.slot_size != sizeof(slot)) {
+      munmap(address, sizeof(layout));
+      return nullptr;
+    }
+
+    return std::unique_ptr<report_ring>(new report_ring(name, l, false));
+  }
+
+  const name_t& get_name() const {
+    return name_;
+  }
+
+  // Remove the shared memory name.
+  // The mapped memory is still available until both sides release the ring.
+  void unlink() {
+    if (owner_) {
+      owner_ = false;
+      shm_unlink(name_.data());
+    }
+  }
+
+  //
+  // Producer methods
+  //
+
+  template <typename T>
+  push_result push(const T& report) {
+    static_assert(sizeof(report) <= max_input_report_size);
+
+    auto& header = layout_->header;
+
+    auto head = header.head.load(std::memory_order_relaxed);
+    auto tail = header.tail.load(std::memory_order_acquire);
+    if (head - tail >= slot_count) {
+      return push_result::full;
+    }
+
+    auto& s = layout_->slots[head % slot_count];
+    s.request_type = post_report_request<T>();
+    std::memcpy(s.report.data(), &report, sizeof(report));
+
+    // The doorbell is checked after the head is published,
+    // so either this producer sees the armed doorbell or the consumer sees the new head.
+    header.head.store(head + 1, std::memory_order_seq_cst);
+
+    if (header.doorbell_armed.exchange(0, std::memory_order_seq_cst)) {
+      return push_result::doorbell_required;
+    }
+
+    return push_result::pushed;
+  }
+
+  // The number of messages which the consumer has handled through the unix_domain_stream connection.
+  // The producer must not push reports while messages sent through the connection are not handled yet,
+  // because the consumer drains the ring before handling each message.
+  uint64_t get_handled_message_count() const {
+    return layout_->header.handled_message_count.load(std::memory_order_acquire);
+  }
+
+  //
+  // Consumer methods
+  //
+
+  // Call `f(request, report)` for each pushed report in order, and arm the doorbell.
+  //
+  // A call drains at most `slot_count` reports (the reports which are pushed before the call),
+  // so a producer which keeps pushing cannot keep the consumer in this method.
+  template <typename F>
+  drain_result drain(F&& f) {
+    auto& header = layout_->header;
+
+    auto tail = header.tail.load(std::memory_order_relaxed);
+    auto head = header.head.load(std::memory_order_acquire);
+    if (head - tail > slot_count) {
+      return drain_result::broken;
+    }
+
+    for (; tail != head; ++tail) {
+      // Copy the slot before validating it since the producer can modify it.
+      slot s;
+      std::memcpy(&s, &layout_->slots[tail % slot_count], sizeof(s));
+
+      auto report_size = post_report_size(s.request_type);
+      if (!report_size) {
+        return drain_result::broken;
+      }
+
+      f(s.request_type, std::span<const uint8_t>(s.report.data(), *report_size));
+
+      header.tail.store(tail + 1, std::memory_order_release);
+    }
+
+    header.doorbell_armed.store(1, std::memory_order_seq_cst);
+
+    if (header.head.load(std::memory_order_seq_cst) == head) {
+      return drain_result::drained;
+    }
+
+    // Reports which are pushed before the doorbell is armed do not ring the doorbell.
+    // If the producer has not taken the doorbell yet, take it back and let the caller drain again.
+    // Otherwise, the producer sends the doorbell.
+    if (header.doorbell_armed.exchange(0, std::memory_order_seq_cst)) {
+      return drain_result::pending;
+    }
+
+    return drain_result::drained;
+  }
+
+  void set_handled_message_count(uint64_t value) {
+    layout_->header.handled_message_count.store(value, std::memory_order_release);
+  }
+
+private:
+  struct slot final {
+    request request_type;
+    std::array<uint8_t, max_input_report_size> report;
+  };
+
+  struct header_t final {
+    uint32_t magic;
+    uint32_t slot_count;
+    uint32_t slot_size;
+
+    // Written by the producer.
+    alignas(64) std::atomic<uint64_t> head;
+
+    // Written by the consumer.
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> handled_message_count;
+
+    // Set by the consumer, cleared by the producer.
+    alignas(64) std::atomic<uint32_t> doorbell_armed;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free);
+  static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+  struct layout final {
+    header_t header;
+    std::array<slot, slot_count> slots;
+  };
+
+  report_ring(const name_t& name,
+              layout* layout,
+              bool owner)
+      : name_(name),
+        layout_(layout),
+        owner_(owner) {
+  }
+
+  name_t name_;
+  layout* layout_;
+  bool owner_;
+};
+} // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
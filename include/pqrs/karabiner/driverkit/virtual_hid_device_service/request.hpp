@@ -4,6 +4,7 @@
 // Distributed under the Boost Software License, Version 1.0.
 // (See https://www.boost.org/LICENSE_1_0.txt)
 
+#include <cstdint>
 #include <string_view>
 
 namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
@@ -20,5 +21,9 @@ enum class request : uint8_t {
   post_apple_vendor_top_case_input_report,
   post_generic_desktop_input_report,
   post_pointing_input_report,
+  post_report_batch,
+  report_ring_open,
+  report_ring_doorbell,
+  get_statistics,
 };
 } // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
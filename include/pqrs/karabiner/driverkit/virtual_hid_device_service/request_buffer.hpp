@@ -0,0 +1,81 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../client_protocol_version.hpp"
+#include "request.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
+// `request_buffer` is a request payload whose size is fixed at compile time.
+// It is built in place without heap allocation, so the report posting path does not allocate per report.
+//
+// Layout:
+//   buffer[0]: client_protocol_version[0]
+//   buffer[1]: client_protocol_version[1]
+//   buffer[2]: pqrs::karabiner::driverkit::virtual_hid_device_service::request
+//   buffer[3...]: data
+template <size_t DataSize>
+class request_buffer final {
+public:
+  static constexpr size_t header_size = sizeof(client_protocol_version::value_t) + sizeof(request);
+  static constexpr size_t buffer_size = header_size + DataSize;
+
+  explicit request_buffer(request request_type) {
+    write(0, client_protocol_version::embedded_client_protocol_version);
+    write(sizeof(client_protocol_version::value_t), request_type);
+  }
+
+  template <typename T>
+  request_buffer(request request_type,
+                 const T& data)
+      : request_buffer(request_type) {
+    static_assert(sizeof(T) == DataSize);
+
+    write(header_size, data);
+  }
+
+  const uint8_t* data() const {
+    return buffer_.data();
+  }
+
+  constexpr size_t size() const {
+    return buffer_size;
+  }
+
+  auto begin() const {
+    return std::begin(buffer_);
+  }
+
+  auto end() const {
+    return std::end(buffer_);
+  }
+
+private:
+  template <typename T>
+  void write(size_t offset, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    std::memcpy(buffer_.data() + offset,
+                std::addressof(value),
+                sizeof(value));
+  }
+
+  std::array<uint8_t, buffer_size> buffer_;
+};
+
+inline request_buffer<0> make_request_buffer(request request_type) {
+  return request_buffer<0>(request_type);
+}
+
+template <typename T>
+request_buffer<sizeof(T)> make_request_buffer(request request_type, const T& data) {
+  return request_buffer<sizeof(T)>(request_type, data);
+}
+} // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
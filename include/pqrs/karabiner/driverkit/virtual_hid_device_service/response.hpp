@@ -14,5 +14,7 @@ enum class response : uint8_t {
   driver_version_mismatched,
   virtual_hid_keyboard_ready,
   virtual_hid_pointing_ready,
+  report_ring_opened,
+  statistics,
 };
 } // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
@@ -0,0 +1,82 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2026.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "response.hpp"
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pqrs::karabiner::driverkit::virtual_hid_device_service {
+// Per-peer report counters which are returned for `request::get_statistics`.
+// The counters are accumulated in the daemon since the client connected.
+struct statistics final {
+  // The number of received post reports per report type.
+  uint64_t received_keyboard_input_reports;
+  uint64_t received_consumer_input_reports;
+  uint64_t received_apple_vendor_keyboard_input_reports;
+  uint64_t received_apple_vendor_top_case_input_reports;
+  uint64_t received_generic_desktop_input_reports;
+  uint64_t received_pointing_input_reports;
+
+  // The number of received post reports which are passed through `report_ring`. (They are also counted above.)
+  uint64_t received_report_ring_reports;
+
+  // The number of reports passed to the driver.
+  uint64_t forwarded_reports;
+
+  // The number of reports which are dropped since the report size is wrong.
+  uint64_t dropped_reports_by_size_error;
+
+  // The number of reports which are dropped since the virtual device is not initialized.
+  uint64_t dropped_reports_by_missing_device;
+
+  // The number of reports which the driver call failed to post.
+  uint64_t backend_errors;
+
+  // The forward latency in nanoseconds, from receiving a report to returning from the driver call.
+  // These values are 0 until a report is forwarded.
+  uint64_t min_forward_latency;
+  uint64_t mean_forward_latency;
+  uint64_t p99_forward_latency;
+
+  bool operator==(const statistics&) const = default;
+};
+
+static_assert(std::is_trivially_copyable_v<statistics>);
+
+// Layout:
+//   buffer[0]: response::statistics
+//   buffer[1...]: statistics
+//
+// Other responses are encoded as pairs of (response, value),
+// so a response which begins with `response::statistics` is decoded by `parse_statistics_response`.
+inline std::vector<uint8_t> make_statistics_response(const statistics& value) {
+  std::vector<uint8_t> buffer(1 + sizeof(value));
+  buffer[0] = std::to_underlying(response::statistics);
+  std::memcpy(buffer.data() + 1,
+              &value,
+              sizeof(value));
+  return buffer;
+}
+
+// Returns std::nullopt if the buffer is not a statistics response.
+inline std::optional<statistics> parse_statistics_response(std::span<const uint8_t> buffer) {
+  if (buffer.size() != 1 + sizeof(statistics) ||
+      buffer[0] != std::to_underlying(response::statistics)) {
+    return std::nullopt;
+  }
+
+  statistics value;
+  std::memcpy(&value,
+              buffer.data() + 1,
+              sizeof(value));
+  return value;
+}
+} // namespace pqrs::karabiner::driverkit::virtual_hid_device_service
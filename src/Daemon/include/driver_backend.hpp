@@ -0,0 +1,148 @@
+#pragma once
+
+#include "report_worker_pool.hpp"
+#include <cstdint>
+#include <memory>
+#include <nod/nod.hpp>
+#include <optional>
+#include <pqrs/dispatcher.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+// `driver_client` is a connection to the virtual HID device driver.
+// The daemon creates a driver client for each device of each peer.
+//
+// `io_service_client` connects to the DriverKit driver through IOKit,
+// and `loopback_driver_client` records reports in the daemon process.
+class driver_client : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  // Signals (invoked from the dispatcher thread)
+
+  nod::signal<void()> opened;
+  nod::signal<void()> closed;
+  nod::signal<void()> state_changed;
+
+  // Methods
+
+  // If `report_strand` is specified, device initializations, device resets and reports are passed to the driver in the strand instead of the dispatcher thread.
+  driver_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                std::optional<report_worker_pool::strand> report_strand)
+      : dispatcher_client(weak_dispatcher),
+        report_strand_(report_strand) {
+  }
+
+  // Open the connection to the driver.
+  // `opened` is signaled when the connection is opened.
+  virtual void async_start() = 0;
+
+  virtual bool driver_activated() const = 0;
+  virtual bool driver_connected() const = 0;
+  virtual bool driver_version_mismatched() const = 0;
+
+  // These methods return the readiness which is updated by `async_virtual_hid_*_ready`.
+  virtual std::optional<bool> get_virtual_hid_keyboard_ready() const = 0;
+  virtual std::optional<bool> get_virtual_hid_pointing_ready() const = 0;
+
+  virtual void async_virtual_hid_keyboard_initialize(const pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters& parameters) const = 0;
+  virtual void async_virtual_hid_keyboard_ready() = 0;
+  virtual void async_virtual_hid_keyboard_reset() const = 0;
+
+  virtual void async_virtual_hid_pointing_initialize() const = 0;
+  virtual void async_virtual_hid_pointing_ready() = 0;
+  virtual void async_virtual_hid_pointing_reset() const = 0;
+
+  // `posted` is called with the result after the driver call returns.
+  // (`posted` is a `basic_task` instead of `std::function` to store its captures without heap allocation.)
+  virtual void async_post_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+                                 std::shared_ptr<std::vector<uint8_t>> report_buffer,
+                                 size_t report_offset,
+                                 size_t report_size,
+                                 const char* report_name,
+                                 pqrs::dispatcher::basic_task<void(bool)> posted = nullptr) const = 0;
+
+  // Driver backends create driver clients by this method.
+  //
+  // The functions in the report strand refer the client,
+  // so the client is not deleted when the last `shared_ptr` is released.
+  // Instead, the deletion is posted to the report strand after these functions,
+  // and the client is deleted in the dispatcher thread, where it is detached from the dispatcher.
+  // Thus, releasing a client does not wait for a slow driver call in the dispatcher thread.
+  template <typename T, typename... Args>
+  static std::shared_ptr<driver_client> make(Args&&... args) {
+    return std::shared_ptr<driver_client>(new T(std::forward<Args>(args)...),
+                                          async_delete);
+  }
+
+protected:
+  // Device initializations, device resets and reports are executed in the report strand in order to keep their order.
+  template <typename F>
+  void enqueue_to_report_strand(F&& function) const {
+    if (report_strand_) {
+      report_strand_->post(std::forward<F>(function));
+    } else {
+      enqueue_to_dispatcher(std::forward<F>(function));
+    }
+  }
+
+private:
+  // This method is executed in the thread which releases the last `shared_ptr` (usually the dispatcher thread).
+  static void async_delete(driver_client* p) {
+    // The client without the report strand is deleted here.
+    std::unique_ptr<driver_client> client(p);
+
+    // The owner of the slots may be destroyed before the client is deleted.
+    client->opened.disconnect_all_slots();
+    client->closed.disconnect_all_slots();
+    client->state_changed.disconnect_all_slots();
+
+    if (auto strand = client->report_strand_) {
+      strand->post([client = std::move(client)] mutable {
+        // The strand refers the worker pool, which may be destroyed before the client is deleted in the dispatcher thread.
+        client->report_strand_ = std::nullopt;
+
+        // If the dispatcher is terminating, the client is deleted here.
+        auto c = client.get();
+        pqrs::dispatcher::task function([client = std::move(client)] mutable {
+          client = nullptr;
+        });
+        c->enqueue_to_dispatcher(std::move(function));
+      });
+    }
+  }
+
+  std::optional<report_worker_pool::strand> report_strand_;
+};
+
+// `device_monitor` notifies that virtual HID devices are started or terminated,
+// so that the readiness does not have to be polled.
+class device_monitor : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  // Signals (invoked from the dispatcher thread)
+
+  nod::signal<void()> device_changed;
+  // The readiness has to be polled after `error_occurred` is signaled.
+  nod::signal<void()> error_occurred;
+
+  // Methods
+
+  explicit device_monitor(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher)
+      : dispatcher_client(weak_dispatcher) {
+  }
+
+  virtual void async_start() = 0;
+};
+
+// `driver_backend` creates driver clients and device monitors of a driver implementation.
+class driver_backend {
+public:
+  virtual ~driver_backend() = default;
+
+  virtual std::shared_ptr<driver_client> make_driver_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                                                            const std::string& log_label,
+                                                            std::optional<report_worker_pool::strand> report_strand = std::nullopt) = 0;
+
+  virtual std::unique_ptr<device_monitor> make_device_monitor(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher) = 0;
+};
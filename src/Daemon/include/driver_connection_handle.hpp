@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// `driver_connection_handle` publishes the driver connection to the report strands without locking.
+//
+// The connection is opened and closed in the dispatcher thread, and driver calls read it from any thread.
+// A driver call registers itself in `active_calls_` before it loads the handle,
+// and `unpublish` waits for the registered calls after it clears the handle.
+// Thus, the connection is never closed during a driver call,
+// while a driver call costs an atomic increment and decrement of a counter which is shared only by the calls of one driver client.
+//
+// `T` is a handle type such as `io_connect_t`, and `T{}` means no connection.
+template <typename T>
+class driver_connection_handle final {
+public:
+  driver_connection_handle(const driver_connection_handle&) = delete;
+
+  driver_connection_handle()
+      : handle_(T{}),
+        active_calls_(0) {
+  }
+
+  // Returns `function(handle)`, or `not_open` if no connection is published.
+  // This method can be called from any thread.
+  template <typename F, typename R>
+  R call(F&& function, R not_open) const {
+    active_calls_.fetch_add(1);
+
+    R result = not_open;
+    if (auto handle = handle_.load(); handle != T{}) {
+      result = function(handle);
+    }
+
+    active_calls_.fetch_sub(1, std::memory_order_release);
+
+    return result;
+  }
+
+  // This method is executed in the dispatcher thread.
+  void publish(T handle) {
+    handle_.store(handle);
+  }
+
+  // Clear the handle and wait until no driver call uses it.
+  // The caller closes the connection after this method returns.
+  //
+  // This method is executed in the dispatcher thread.
+  void unpublish() {
+    handle_.store(T{});
+
+    // A driver call which loads the handle before the store above has been registered in `active_calls_`.
+    // (Both the store and this load are sequentially consistent as `call` increments and loads in the opposite order.)
+    while (active_calls_.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+private:
+  std::atomic<T> handle_;
+  mutable std::atomic<uint32_t> active_calls_;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <pqrs/karabiner/driverkit/driver_version.hpp>
+
+// `driver_status` holds the connection state of a driver client in one atomic word,
+// so the report path checks whether reports can be posted with a single load instead of locking mutexes.
+//
+// Layout:
+// - bit 0: The driver version is known. (The driver is connected.)
+// - bit 1: The driver version is mismatched with the embedded driver version.
+// - bit 2,3: virtual_hid_keyboard_ready (has value, value)
+// - bit 4,5: virtual_hid_pointing_ready (has value, value)
+//
+// The driver version itself is 64 bits wide and does not fit in the word,
+// so it is kept in `driver_version_` and stored before the word is updated.
+//
+// The setters are called in the dispatcher thread, and the getters can be called from any thread.
+// `get_snapshot` is consistent when it is called in the dispatcher thread.
+class driver_status final {
+public:
+  struct snapshot final {
+    std::optional<pqrs::karabiner::driverkit::driver_version::value_t> driver_version;
+    bool driver_version_mismatched;
+    std::optional<bool> virtual_hid_keyboard_ready;
+    std::optional<bool> virtual_hid_pointing_ready;
+  };
+
+  driver_status(const driver_status&) = delete;
+
+  driver_status()
+      : word_(0),
+        driver_version_(0) {
+  }
+
+  snapshot get_snapshot() const noexcept {
+    auto w = word_.load(std::memory_order_acquire);
+    auto v = driver_version_.load(std::memory_order_acquire);
+
+    return snapshot{
+        .driver_version = (w & driver_connected_bit)
+                              ? std::optional(pqrs::karabiner::driverkit::driver_version::value_t(v))
+                              : std::nullopt,
+        .driver_version_mismatched = static_cast<bool>(w & driver_version_mismatched_bit),
+        .virtual_hid_keyboard_ready = decode_ready(w >> virtual_hid_keyboard_ready_shift),
+        .virtual_hid_pointing_ready = decode_ready(w >> virtual_hid_pointing_ready_shift),
+    };
+  }
+
+  bool driver_connected() const noexcept {
+    return word_.load(std::memory_order_acquire) & driver_connected_bit;
+  }
+
+  // Returns false until the driver is connected to avoid treating it as unmatched at startup.
+  bool driver_version_mismatched() const noexcept {
+    return word_.load(std::memory_order_acquire) & driver_version_mismatched_bit;
+  }
+
+  // Returns true if the driver is connected and its version is matched.
+  bool driver_usable() const noexcept {
+    return (word_.load(std::memory_order_acquire) & (driver_connected_bit | driver_version_mismatched_bit)) == driver_connected_bit;
+  }
+
+  std::optional<bool> get_virtual_hid_keyboard_ready() const noexcept {
+    auto w = word_.load(std::memory_order_acquire);
+    if (!usable(w)) {
+      return std::nullopt;
+    }
+    return decode_ready(w >> virtual_hid_keyboard_ready_shift);
+  }
+
+  std::optional<bool> get_virtual_hid_pointing_ready() const noexcept {
+    auto w = word_.load(std::memory_order_acquire);
+    if (!usable(w)) {
+      return std::nullopt;
+    }
+    return decode_ready(w >> virtual_hid_pointing_ready_shift);
+  }
+
+  // Returns true if the value is changed.
+  bool set_driver_version(std::optional<pqrs::karabiner::driverkit::driver_version::value_t> value) noexcept {
+    uint64_t bits = 0;
+    uint64_t v = 0;
+    if (value) {
+      bits |= driver_connected_bit;
+      if (*value != pqrs::karabiner::driverkit::driver_version::embedded_driver_version) {
+        bits |= driver_version_mismatched_bit;
+      }
+      v = type_safe::get(*value);
+    }
+
+    bool version_changed = driver_version_.exchange(v, std::memory_order_release) != v;
+    bool word_changed = update(driver_connected_bit | driver_version_mismatched_bit,
+                               bits);
+
+    return version_changed || word_changed;
+  }
+
+  // Returns true if the value is changed.
+  bool set_virtual_hid_keyboard_ready(std::optional<bool> value) noexcept {
+    return update(ready_mask << virtual_hid_keyboard_ready_shift,
+                  encode_ready(value) << virtual_hid_keyboard_ready_shift);
+  }
+
+  // Returns true if the value is changed.
+  bool set_virtual_hid_pointing_ready(std::optional<bool> value) noexcept {
+    return update(ready_mask << virtual_hid_pointing_ready_shift,
+                  encode_ready(value) << virtual_hid_pointing_ready_shift);
+  }
+
+private:
+  static constexpr uint64_t driver_connected_bit = 1 << 0;
+  static constexpr uint64_t driver_version_mismatched_bit = 1 << 1;
+  static constexpr int virtual_hid_keyboard_ready_shift = 2;
+  static constexpr int virtual_hid_pointing_ready_shift = 4;
+  static constexpr uint64_t ready_mask = 0b11;
+
+  static bool usable(uint64_t w) noexcept {
+    return (w & (driver_connected_bit | driver_version_mismatched_bit)) == driver_connected_bit;
+  }
+
+  static uint64_t encode_ready(std::optional<bool> value) noexcept {
+    if (!value) {
+      return 0;
+    }
+    return *value ? 0b11 : 0b01;
+  }
+
+  static std::optional<bool> decode_ready(uint64_t bits) noexcept {
+    if (!(bits & 0b01)) {
+      return std::nullopt;
+    }
+    return static_cast<bool>(bits & 0b10);
+  }
+
+  bool update(uint64_t mask,
+              uint64_t bits) noexcept {
+    auto w = word_.load(std::memory_order_relaxed);
+    while (true) {
+      auto new_word = (w & ~mask) | (bits & mask);
+      if (new_word == w) {
+        return false;
+      }
+      if (word_.compare_exchange_weak(w, new_word, std::memory_order_release, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+  }
+
+  std::atomic<uint64_t> word_;
+  std::atomic<uint64_t> driver_version_;
+};
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "driver_backend.hpp"
+#include "driver_connection_handle.hpp"
+#include "driver_status.hpp"
+#include "log_limiter.hpp"
 #include "logger.hpp"
 #include "version.hpp"
 #include <IOKit/IOKitLib.h>
 #include <array>
+#include <functional>
 #include <gsl/gsl>
 #include <memory>
 #include <nod/nod.hpp>
@@ -21,26 +26,22 @@
 #include <pqrs/osx/iokit_service_monitor.hpp>
 #include <vector>
 
-class io_service_client final : public pqrs::dispatcher::extra::dispatcher_client {
+// `io_service_client` connects to the DriverKit driver through IOKit.
+class io_service_client final : public driver_client {
 public:
-  // Signals (invoked from the dispatcher thread)
-
-  nod::signal<void()> opened;
-  nod::signal<void()> closed;
-  nod::signal<void()> state_changed;
-
-  // Methods
-
+  // If `report_strand` is specified, device initializations, device resets and reports are passed to the driver in the strand instead of the dispatcher thread.
   io_service_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
                     pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread,
-                    const std::string& log_label)
-      : dispatcher_client(weak_dispatcher),
+                    const std::string& log_label,
+                    std::optional<report_worker_pool::strand> report_strand = std::nullopt)
+      : driver_client(weak_dispatcher,
+                      report_strand),
         run_loop_thread_(run_loop_thread),
         log_label_(log_label),
         service_name_("org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceRoot") {
   }
 
-  ~io_service_client() {
+  ~io_service_client() override {
     detach_from_dispatcher([this] {
       if (auto matched_service = matched_services_.find_opened()) {
         close_connection(matched_service->get_registry_entry_id());
@@ -50,70 +51,30 @@ public:
     });
   }
 
-  bool driver_activated() const {
+  bool driver_activated() const override {
     auto service = pqrs::osx::adopt_iokit_object_ptr(
         IOServiceGetMatchingService(type_safe::get(pqrs::osx::iokit_mach_port::null),
                                     IOServiceNameMatching(service_name_.c_str())));
     return static_cast<bool>(service);
   }
 
-  bool driver_connected() const {
-    std::lock_guard<std::mutex> lock(driver_version_mutex_);
-
-    return driver_version_ != std::nullopt;
+  bool driver_connected() const override {
+    return driver_status_.driver_connected();
   }
 
-  bool driver_version_mismatched() const {
-    std::lock_guard<std::mutex> lock(driver_version_mutex_);
-
-    // Return false until driver is loaded to avoid treating it as unmatched at startup.
-    if (driver_version_ == std::nullopt) {
-      return false;
-    }
-
-    if (driver_version_ == pqrs::karabiner::driverkit::driver_version::embedded_driver_version) {
-      return false;
-    }
-
-    auto message = fmt::format("{0} driver_version_ is mismatched: Karabiner-VirtualHIDDevice-Daemon expected: {1}, actual dext: {2}",
-                               log_label_,
-                               type_safe::get(pqrs::karabiner::driverkit::driver_version::embedded_driver_version),
-                               type_safe::get(*driver_version_));
-    if (driver_version_mismatched_log_message_ != message) {
-      driver_version_mismatched_log_message_ = message;
-      logger::get_logger()->warn(message);
-    }
-
-    return true;
+  bool driver_version_mismatched() const override {
+    return driver_status_.driver_version_mismatched();
   }
 
-  std::optional<bool> get_virtual_hid_keyboard_ready() const {
-    if (!driver_connected() ||
-        driver_version_mismatched()) {
-      return std::nullopt;
-    }
-
-    {
-      std::lock_guard<std::mutex> lock(virtual_hid_keyboard_ready_mutex_);
-
-      return virtual_hid_keyboard_ready_;
-    }
+  std::optional<bool> get_virtual_hid_keyboard_ready() const override {
+    return driver_status_.get_virtual_hid_keyboard_ready();
   }
 
-  std::optional<bool> get_virtual_hid_pointing_ready() const {
-    if (!driver_connected() ||
-        driver_version_mismatched()) {
-      return std::nullopt;
-    }
-
-    {
-      std::lock_guard<std::mutex> lock(virtual_hid_pointing_ready_mutex_);
-
-      return virtual_hid_pointing_ready_;
-    }
+  std::optional<bool> get_virtual_hid_pointing_ready() const override {
+    return driver_status_.get_virtual_hid_pointing_ready();
   }
 
-  void async_start() {
+  void async_start() override {
     enqueue_to_dispatcher([this] {
       if (auto matching_dictionary = pqrs::cf::adopt_cf_ptr(IOServiceNameMatching(service_name_.c_str()))) {
         service_monitor_ = std::make_unique<pqrs::osx::iokit_service_monitor>(weak_dispatcher_,
@@ -129,9 +90,11 @@ public:
 
           open_connection();
 
-          enqueue_to_dispatcher([this] {
-            state_changed();
-          });
+          enqueue_to_dispatcher(
+              [this] {
+                state_changed();
+              },
+              pqrs::dispatcher::priority::low);
         });
 
         service_monitor_->service_terminated.connect([this](auto&& registry_entry_id) {
@@ -146,9 +109,11 @@ public:
           // we attempt to connect to the next available service.
           open_connection();
 
-          enqueue_to_dispatcher([this] {
-            state_changed();
-          });
+          enqueue_to_dispatcher(
+              [this] {
+                state_changed();
+              },
+              pqrs::dispatcher::priority::low);
         });
 
         service_monitor_->error_occurred.connect([this](auto&& message, auto&& kern_return) {
@@ -163,8 +128,8 @@ public:
     });
   }
 
-  void async_virtual_hid_keyboard_initialize(const pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters& parameters) const {
-    enqueue_to_dispatcher([this, parameters] {
+  void async_virtual_hid_keyboard_initialize(const pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters& parameters) const override {
+    enqueue_to_report_strand([this, parameters] {
       std::array<uint64_t, 3> input = {
           type_safe::get(parameters.get_vendor_id()),
           type_safe::get(parameters.get_product_id()),
@@ -183,17 +148,21 @@ public:
     });
   }
 
-  void async_virtual_hid_keyboard_ready() {
-    enqueue_to_dispatcher([this] {
-      enqueue_to_dispatcher([this,
-                             ready = call_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_ready)] {
-        set_virtual_hid_keyboard_ready(ready);
-      });
-    });
+  void async_virtual_hid_keyboard_ready() override {
+    enqueue_to_dispatcher(
+        [this] {
+          enqueue_to_dispatcher(
+              [this,
+               ready = call_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_ready)] {
+                set_virtual_hid_keyboard_ready(ready);
+              },
+              pqrs::dispatcher::priority::low);
+        },
+        pqrs::dispatcher::priority::low);
   }
 
-  void async_virtual_hid_keyboard_reset() const {
-    enqueue_to_dispatcher([this] {
+  void async_virtual_hid_keyboard_reset() const override {
+    enqueue_to_report_strand([this] {
       auto result = call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_reset);
 
       if (!result) {
@@ -204,8 +173,8 @@ public:
     });
   }
 
-  void async_virtual_hid_pointing_initialize() const {
-    enqueue_to_dispatcher([this] {
+  void async_virtual_hid_pointing_initialize() const override {
+    enqueue_to_report_strand([this] {
       auto result = call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_initialize);
 
       if (!result) {
@@ -216,17 +185,21 @@ public:
     });
   }
 
-  void async_virtual_hid_pointing_ready() {
-    enqueue_to_dispatcher([this] {
-      enqueue_to_dispatcher([this,
-                             ready = call_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_ready)] {
-        set_virtual_hid_pointing_ready(ready);
-      });
-    });
+  void async_virtual_hid_pointing_ready() override {
+    enqueue_to_dispatcher(
+        [this] {
+          enqueue_to_dispatcher(
+              [this,
+               ready = call_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_ready)] {
+                set_virtual_hid_pointing_ready(ready);
+              },
+              pqrs::dispatcher::priority::low);
+        },
+        pqrs::dispatcher::priority::low);
   }
 
-  void async_virtual_hid_pointing_reset() const {
-    enqueue_to_dispatcher([this] {
+  void async_virtual_hid_pointing_reset() const override {
+    enqueue_to_report_strand([this] {
       auto result = call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_reset);
 
       if (!result) {
@@ -240,26 +213,37 @@ public:
   void async_post_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
                          std::shared_ptr<std::vector<uint8_t>> report_buffer,
                          size_t report_offset,
-                         const char* report_name) const {
-    enqueue_to_dispatcher([this, user_client_method, report_buffer, report_offset, report_name] {
+                         size_t report_size,
+                         const char* report_name,
+                         pqrs::dispatcher::basic_task<void(bool)> posted = nullptr) const override {
+    enqueue_to_report_strand([this, user_client_method, report_buffer, report_offset, report_size, report_name, posted = std::move(posted)] mutable {
       if (!report_buffer ||
-          report_offset > report_buffer->size()) {
-        logger::get_logger()->error("{0} async_post_report invalid buffer",
-                                    log_label_);
+          report_offset > report_buffer->size() ||
+          report_size > report_buffer->size() - report_offset) {
+        if (auto suppressed_count = post_report_error_log_limiter_.acquire()) {
+          logger::get_logger()->error("{0} async_post_report invalid buffer{1}",
+                                      log_label_,
+                                      log_limiter::make_suppressed_message(*suppressed_count));
+        }
         return;
       }
 
-      auto report_size = report_buffer->size() - report_offset;
-
       auto result = post_report(user_client_method,
                                 report_buffer->data() + report_offset,
                                 report_size);
 
       if (!result) {
-        logger::get_logger()->error("{0} {1} error: {2}",
-                                    log_label_,
-                                    report_name,
-                                    result.to_string());
+        if (auto suppressed_count = post_report_error_log_limiter_.acquire(static_cast<uint32_t>(result.get()))) {
+          logger::get_logger()->error("{0} {1} error: {2}{3}",
+                                      log_label_,
+                                      report_name,
+                                      result.to_string(),
+                                      log_limiter::make_suppressed_message(*suppressed_count));
+        }
+      }
+
+      if (posted) {
+        posted(static_cast<bool>(result));
       }
     });
   }
@@ -362,61 +346,62 @@ private:
 
   // This method is executed in the dispatcher thread.
   void set_driver_version(std::optional<pqrs::karabiner::driverkit::driver_version::value_t> value) {
-    std::lock_guard<std::mutex> lock(driver_version_mutex_);
-
-    if (driver_version_ != value) {
-      driver_version_ = value;
-
+    if (driver_status_.set_driver_version(value)) {
       if (value) {
         logger::get_logger()->debug(
             "{0} driver_version_ is changed: {1}",
             log_label_,
             type_safe::get(*value));
+
+        if (driver_status_.driver_version_mismatched()) {
+          logger::get_logger()->warn("{0} driver_version_ is mismatched: Karabiner-VirtualHIDDevice-Daemon expected: {1}, actual dext: {2}",
+                                     log_label_,
+                                     type_safe::get(pqrs::karabiner::driverkit::driver_version::embedded_driver_version),
+                                     type_safe::get(*value));
+        }
       } else {
         logger::get_logger()->debug(
             "{0} driver_version_ is changed: std::nullopt",
             log_label_);
       }
 
-      enqueue_to_dispatcher([this] {
-        state_changed();
-      });
+      enqueue_to_dispatcher(
+          [this] {
+            state_changed();
+          },
+          pqrs::dispatcher::priority::low);
     }
   }
 
   // This method is executed in the dispatcher thread.
   void set_virtual_hid_keyboard_ready(std::optional<bool> value) {
-    std::lock_guard<std::mutex> lock(virtual_hid_keyboard_ready_mutex_);
-
-    if (virtual_hid_keyboard_ready_ != value) {
-      virtual_hid_keyboard_ready_ = value;
-
+    if (driver_status_.set_virtual_hid_keyboard_ready(value)) {
       logger::get_logger()->debug(
           "{0} virtual_hid_keyboard_ready_ is changed: {1}",
           log_label_,
           value ? (*value ? "true" : "false") : "std::nullopt");
 
-      enqueue_to_dispatcher([this] {
-        state_changed();
-      });
+      enqueue_to_dispatcher(
+          [this] {
+            state_changed();
+          },
+          pqrs::dispatcher::priority::low);
     }
   }
 
   // This method is executed in the dispatcher thread.
   void set_virtual_hid_pointing_ready(std::optional<bool> value) {
-    std::lock_guard<std::mutex> lock(virtual_hid_pointing_ready_mutex_);
-
-    if (virtual_hid_pointing_ready_ != value) {
-      virtual_hid_pointing_ready_ = value;
-
+    if (driver_status_.set_virtual_hid_pointing_ready(value)) {
       logger::get_logger()->debug(
           "{0} virtual_hid_pointing_ready_ is changed: {1}",
           log_label_,
           value ? (*value ? "true" : "false") : "std::nullopt");
 
-      enqueue_to_dispatcher([this] {
-        state_changed();
-      });
+      enqueue_to_dispatcher(
+          [this] {
+            state_changed();
+          },
+          pqrs::dispatcher::priority::low);
     }
   }
 
@@ -463,6 +448,7 @@ private:
       }
 
       connection_ = pqrs::osx::iokit_object_ptr(new_connection);
+      connection_handle_.publish(new_connection);
       matched_service->set_opened(true);
 
       enqueue_to_dispatcher([this] {
@@ -487,6 +473,9 @@ private:
       return;
     }
 
+    // Wait for the driver calls in the report strand before the connection is closed.
+    connection_handle_.unpublish();
+
     IOServiceClose(*connection_);
     connection_.reset();
 
@@ -505,8 +494,7 @@ private:
       return std::nullopt;
     }
 
-    // Do not call `driver_connected()` here.
-    // Do not call `driver_version_mismatched()` here.
+    // Do not check `driver_status_` here.
 
     uint64_t output[1] = {0};
     uint32_t output_count = 1;
@@ -524,44 +512,42 @@ private:
     return pqrs::karabiner::driverkit::driver_version::value_t(output[0]);
   }
 
-  // This method is executed in the dispatcher thread.
+  // This method is executed in the dispatcher thread or the report strand.
   pqrs::osx::iokit_return call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method) const {
-    if (!connection_) {
-      return kIOReturnNotOpen;
-    }
-
-    if (!driver_connected() ||
-        driver_version_mismatched()) {
-      return kIOReturnError;
-    }
-
-    return IOConnectCallStructMethod(*connection_,
-                                     static_cast<uint32_t>(user_client_method),
-                                     nullptr,
-                                     0,
-                                     nullptr,
-                                     0);
+    return connection_handle_.call(
+        [this, user_client_method](io_connect_t connection) -> pqrs::osx::iokit_return {
+          if (!driver_status_.driver_usable()) {
+            return kIOReturnError;
+          }
+
+          return IOConnectCallStructMethod(connection,
+                                           static_cast<uint32_t>(user_client_method),
+                                           nullptr,
+                                           0,
+                                           nullptr,
+                                           0);
+        },
+        pqrs::osx::iokit_return(kIOReturnNotOpen));
   }
 
-  // This method is executed in the dispatcher thread.
+  // This method is executed in the dispatcher thread or the report strand.
   pqrs::osx::iokit_return call_scalar_method(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
                                              const uint64_t* input,
                                              uint32_t input_count) const {
-    if (!connection_) {
-      return kIOReturnNotOpen;
-    }
-
-    if (!driver_connected() ||
-        driver_version_mismatched()) {
-      return kIOReturnError;
-    }
-
-    return IOConnectCallScalarMethod(*connection_,
-                                     static_cast<uint32_t>(user_client_method),
-                                     input,
-                                     input_count,
-                                     nullptr,
-                                     0);
+    return connection_handle_.call(
+        [this, user_client_method, input, input_count](io_connect_t connection) -> pqrs::osx::iokit_return {
+          if (!driver_status_.driver_usable()) {
+            return kIOReturnError;
+          }
+
+          return IOConnectCallScalarMethod(connection,
+                                           static_cast<uint32_t>(user_client_method),
+                                           input,
+                                           input_count,
+                                           nullptr,
+                                           0);
+        },
+        pqrs::osx::iokit_return(kIOReturnNotOpen));
   }
 
   // This method is executed in the dispatcher thread.
@@ -570,8 +556,7 @@ private:
       return std::nullopt;
     }
 
-    if (!driver_connected() ||
-        driver_version_mismatched()) {
+    if (!driver_status_.driver_usable()) {
       return std::nullopt;
     }
 
@@ -591,25 +576,24 @@ private:
     return static_cast<bool>(output[0]);
   }
 
-  // This method is executed in the dispatcher thread.
+  // This method is executed in the report strand.
   pqrs::osx::iokit_return post_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
                                       const void* report,
                                       size_t report_size) const {
-    if (!connection_) {
-      return kIOReturnNotOpen;
-    }
-
-    if (!driver_connected() ||
-        driver_version_mismatched()) {
-      return kIOReturnError;
-    }
-
-    return IOConnectCallStructMethod(*connection_,
-                                     static_cast<uint32_t>(user_client_method),
-                                     report,
-                                     report_size,
-                                     nullptr,
-                                     0);
+    return connection_handle_.call(
+        [this, user_client_method, report, report_size](io_connect_t connection) -> pqrs::osx::iokit_return {
+          if (!driver_status_.driver_usable()) {
+            return kIOReturnError;
+          }
+
+          return IOConnectCallStructMethod(connection,
+                                           static_cast<uint32_t>(user_client_method),
+                                           report,
+                                           report_size,
+                                           nullptr,
+                                           0);
+        },
+        pqrs::osx::iokit_return(kIOReturnNotOpen));
   }
 
   pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread_;
@@ -617,16 +601,16 @@ private:
   std::string service_name_;
   std::unique_ptr<pqrs::osx::iokit_service_monitor> service_monitor_;
   matched_services matched_services_;
-  pqrs::osx::iokit_object_ptr connection_;
 
-  mutable std::mutex driver_version_mutex_;
-  std::optional<pqrs::karabiner::driverkit::driver_version::value_t> driver_version_;
-  // Remember last log message in order to suppress duplicated messages.
-  mutable std::string driver_version_mismatched_log_message_;
+  // `connection_` is changed and used only in the dispatcher thread.
+  // Driver calls which may run in the report strand use `connection_handle_` instead,
+  // which is published while `connection_` is open.
+  pqrs::osx::iokit_object_ptr connection_;
+  driver_connection_handle<io_connect_t> connection_handle_;
 
-  mutable std::mutex virtual_hid_keyboard_ready_mutex_;
-  std::optional<bool> virtual_hid_keyboard_ready_;
+  // The driver version and the readiness of virtual HID devices.
+  driver_status driver_status_;
 
-  mutable std::mutex virtual_hid_pointing_ready_mutex_;
-  std::optional<bool> virtual_hid_pointing_ready_;
+  // Errors of posted reports are repeated for each report while the driver is unavailable.
+  mutable log_limiter post_report_error_log_limiter_;
 };
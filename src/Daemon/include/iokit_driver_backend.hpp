@@ -0,0 +1,31 @@
+#pragma once
+
+#include "driver_backend.hpp"
+#include "io_service_client.hpp"
+#include "virtual_hid_device_monitor.hpp"
+#include <pqrs/cf/run_loop_thread.hpp>
+
+// `iokit_driver_backend` connects to the DriverKit driver through IOKit.
+class iokit_driver_backend final : public driver_backend {
+public:
+  explicit iokit_driver_backend(pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread)
+      : run_loop_thread_(run_loop_thread) {
+  }
+
+  std::shared_ptr<driver_client> make_driver_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                                                    const std::string& log_label,
+                                                    std::optional<report_worker_pool::strand> report_strand) override {
+    return driver_client::make<io_service_client>(weak_dispatcher,
+                                                  run_loop_thread_,
+                                                  log_label,
+                                                  report_strand);
+  }
+
+  std::unique_ptr<device_monitor> make_device_monitor(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher) override {
+    return std::make_unique<virtual_hid_device_monitor>(weak_dispatcher,
+                                                        run_loop_thread_);
+  }
+
+private:
+  pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread_;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// `log_limiter` limits log messages of a call site on hot paths, such as errors of each posted report.
+//
+// - `acquire()` allows `burst` messages per `interval`.
+// - `acquire(key)` also suppresses messages with the same key as the last allowed message (e.g., the same error code) within `interval`.
+//
+// They return std::nullopt if the message should be suppressed, or the number of messages suppressed since the last allowed message.
+// The methods do not lock and can be called from any thread.
+// (The limits are approximate when threads call them at the same time.)
+class log_limiter final {
+public:
+  log_limiter(const log_limiter&) = delete;
+
+  explicit log_limiter(std::chrono::steady_clock::duration interval = std::chrono::seconds(10),
+                       uint64_t burst = 5)
+      : interval_(interval),
+        burst_(burst),
+        window_start_(std::chrono::steady_clock::duration::min().count()),
+        window_count_(0),
+        suppressed_count_(0),
+        last_key_(0),
+        last_key_time_(std::chrono::steady_clock::duration::min().count()) {
+  }
+
+  std::optional<uint64_t> acquire(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+    auto now_count = now.time_since_epoch().count();
+
+    auto window_start = window_start_.load(std::memory_order_relaxed);
+    if (elapsed(window_start, now_count) &&
+        window_start_.compare_exchange_strong(window_start, now_count, std::memory_order_relaxed)) {
+      window_count_.store(0, std::memory_order_relaxed);
+    }
+
+    if (window_count_.fetch_add(1, std::memory_order_relaxed) >= burst_) {
+      suppressed_count_.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+
+    return suppressed_count_.exchange(0, std::memory_order_relaxed);
+  }
+
+  std::optional<uint64_t> acquire(uint64_t key,
+                                  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) {
+    auto now_count = now.time_since_epoch().count();
+
+    if (last_key_.load(std::memory_order_relaxed) == key &&
+        !elapsed(last_key_time_.load(std::memory_order_relaxed), now_count)) {
+      suppressed_count_.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+
+    auto result = acquire(now);
+    if (result) {
+      last_key_.store(key, std::memory_order_relaxed);
+      last_key_time_.store(now_count, std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  // Returns the text appended to the allowed message. (e.g., " (3 similar messages were suppressed)")
+  static std::string make_suppressed_message(uint64_t suppressed_count) {
+    if (suppressed_count == 0) {
+      return "";
+    }
+    return " (" + std::to_string(suppressed_count) + " similar messages were suppressed)";
+  }
+
+private:
+  bool elapsed(std::chrono::steady_clock::rep since,
+               std::chrono::steady_clock::rep now) const {
+    return since == std::chrono::steady_clock::duration::min().count() ||
+           now - since >= interval_.count();
+  }
+
+  std::chrono::steady_clock::duration interval_;
+  uint64_t burst_;
+
+  std::atomic<std::chrono::steady_clock::rep> window_start_;
+  std::atomic<uint64_t> window_count_;
+  std::atomic<uint64_t> suppressed_count_;
+
+  // `last_key_` is valid while `last_key_time_` is not `duration::min()`.
+  std::atomic<uint64_t> last_key_;
+  std::atomic<std::chrono::steady_clock::rep> last_key_time_;
+};
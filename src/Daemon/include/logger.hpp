@@ -1,29 +1,31 @@
 #pragma once
 
+#include "trace_log.hpp"
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 #include <pqrs/gsl.hpp>
 #include <pqrs/spdlog.hpp>
 #include <spdlog/async.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_sinks.h>
+#include <vector>
 
 class logger final {
 public:
+  // This method is wait-free after the first call, and can be called from any thread.
   static pqrs::not_null_shared_ptr_t<spdlog::logger> get_logger() {
-    std::lock_guard<std::mutex> guard(mutex_);
-
-    if (logger_) {
-      return logger_;
+    if (auto l = logger_.load(std::memory_order_acquire)) {
+      return *l;
     }
 
     //
     // Fallback
     //
 
-    static std::shared_ptr<spdlog::logger> stdout_logger;
-    if (!stdout_logger) {
-      stdout_logger = pqrs::spdlog::factory::make_stdout_logger_mt("client");
-    }
+    static std::shared_ptr<spdlog::logger> stdout_logger = pqrs::spdlog::factory::make_stdout_logger_mt("client");
 
     return stdout_logger;
   }
@@ -38,15 +40,49 @@ public:
                                                                   3);
     if (l) {
       l->set_level(spdlog::level::debug);
-      l->flush_on(spdlog::level::debug);
+      // Debug messages are flushed periodically instead of on each message.
+      l->flush_on(spdlog::level::info);
       l->set_pattern(pqrs::spdlog::get_pattern());
 
+      spdlog::flush_every(std::chrono::seconds(1));
+
       std::lock_guard<std::mutex> guard(mutex_);
-      logger_ = l;
+      loggers_.push_back(std::make_unique<std::shared_ptr<spdlog::logger>>(l));
+      logger_.store(loggers_.back().get(), std::memory_order_release);
+    }
+  }
+
+  // Enable `trace` with a trace file at `trace_file_path`.
+  // Call this method before other threads call `trace`.
+  static bool set_trace_log(const std::filesystem::path& trace_file_path,
+                            size_t max_file_size) {
+    auto t = trace_log::create(trace_file_path, max_file_size);
+    if (!t) {
+      return false;
+    }
+
+    trace_log_pointer_ = t.get();
+    trace_log_ = std::move(t);
+    return true;
+  }
+
+  // Write an event to the trace file if it is enabled.
+  // This method can be called from any thread, and it does not format the arguments or lock.
+  template <typename... Arguments>
+  static void trace(trace_event event,
+                    Arguments... arguments) noexcept {
+    if (auto t = trace_log_pointer_.load(std::memory_order_acquire)) {
+      t->write(event, arguments...);
     }
   }
 
 private:
+  // The published loggers are kept until the process exits,
+  // so `get_logger` can copy `*logger_` without locking even while another logger is being set.
   static inline std::mutex mutex_;
-  static inline std::shared_ptr<spdlog::logger> logger_;
+  static inline std::vector<std::unique_ptr<std::shared_ptr<spdlog::logger>>> loggers_;
+  static inline std::atomic<std::shared_ptr<spdlog::logger>*> logger_ = nullptr;
+
+  static inline std::unique_ptr<trace_log> trace_log_;
+  static inline std::atomic<trace_log*> trace_log_pointer_ = nullptr;
 };
@@ -0,0 +1,354 @@
+#pragma once
+
+#include "driver_backend.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <span>
+
+// `loopback_driver_backend` records reports in the daemon process instead of passing them to the DriverKit driver.
+// It allows running the daemon and client stack on platforms without the driver, such as tests and benchmarks on Linux.
+
+// `loopback_report_sink` records reports and device resets which are passed to loopback driver clients.
+class loopback_report_sink final {
+public:
+  struct record final {
+    std::string log_label;
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method;
+    // `report` is empty for device resets.
+    std::vector<uint8_t> report;
+    std::chrono::steady_clock::time_point recorded_time;
+  };
+
+  // Signals (invoked from the report strand)
+
+  nod::signal<void(const record&)> recorded;
+
+  // Methods
+
+  loopback_report_sink(const loopback_report_sink&) = delete;
+
+  // The sink keeps the latest `capacity` records.
+  // The records are reused after the sink is filled, so recording does not allocate memory in the steady state.
+  explicit loopback_report_sink(size_t capacity = 65536)
+      : capacity_(capacity),
+        recorded_count_(0) {
+  }
+
+  void push(const std::string& log_label,
+            pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+            std::span<const uint8_t> report) {
+    auto recorded_time = std::chrono::steady_clock::now();
+
+    if (!recorded.empty()) {
+      recorded(record{
+          .log_label = log_label,
+          .user_client_method = user_client_method,
+          .report = std::vector<uint8_t>(std::begin(report), std::end(report)),
+          .recorded_time = recorded_time,
+      });
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    ++recorded_count_;
+
+    if (capacity_ == 0) {
+      return;
+    }
+
+    if (records_.size() < capacity_) {
+      records_.emplace_back();
+    }
+
+    auto& r = records_[(recorded_count_ - 1) % capacity_];
+    r.log_label = log_label;
+    r.user_client_method = user_client_method;
+    r.report.assign(std::begin(report), std::end(report));
+    r.recorded_time = recorded_time;
+  }
+
+  std::vector<record> get_records() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // `records_` is a ring buffer after it is filled.
+    auto begin = (records_.size() < capacity_) ? 0 : recorded_count_ % capacity_;
+
+    std::vector<record> result;
+    result.reserve(records_.size());
+    for (size_t i = 0; i < records_.size(); ++i) {
+      result.push_back(records_[(begin + i) % records_.size()]);
+    }
+    return result;
+  }
+
+  // The number of all recorded reports and device resets, including the records which are no longer kept.
+  uint64_t get_recorded_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return recorded_count_;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    records_.clear();
+    recorded_count_ = 0;
+  }
+
+private:
+  size_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::vector<record> records_;
+  uint64_t recorded_count_;
+};
+
+// `loopback_driver_client` emulates the driver connection.
+// A device becomes ready when it is initialized, and the readiness is reported through `async_virtual_hid_*_ready` as the driver does.
+class loopback_driver_client final : public driver_client {
+public:
+  loopback_driver_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                         const std::string& log_label,
+                         std::optional<report_worker_pool::strand> report_strand,
+                         pqrs::not_null_shared_ptr_t<loopback_report_sink> report_sink,
+                         pqrs::not_null_shared_ptr_t<nod::signal<void()>> device_changed)
+      : driver_client(weak_dispatcher,
+                      report_strand),
+        log_label_(log_label),
+        report_sink_(report_sink),
+        device_changed_(device_changed),
+        connected_(false),
+        virtual_hid_keyboard_started_(false),
+        virtual_hid_pointing_started_(false) {
+  }
+
+  ~loopback_driver_client() override {
+    detach_from_dispatcher();
+  }
+
+  void async_start() override {
+    enqueue_to_dispatcher([this] {
+      connected_ = true;
+
+      opened();
+      state_changed();
+    });
+  }
+
+  bool driver_activated() const override {
+    return true;
+  }
+
+  bool driver_connected() const override {
+    return connected_;
+  }
+
+  bool driver_version_mismatched() const override {
+    return false;
+  }
+
+  std::optional<bool> get_virtual_hid_keyboard_ready() const override {
+    std::lock_guard<std::mutex> lock(ready_mutex_);
+
+    return virtual_hid_keyboard_ready_;
+  }
+
+  std::optional<bool> get_virtual_hid_pointing_ready() const override {
+    std::lock_guard<std::mutex> lock(ready_mutex_);
+
+    return virtual_hid_pointing_ready_;
+  }
+
+  void async_virtual_hid_keyboard_initialize(const pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters& parameters) const override {
+    enqueue_to_report_strand([this] {
+      start_device(virtual_hid_keyboard_started_);
+    });
+  }
+
+  void async_virtual_hid_keyboard_ready() override {
+    enqueue_to_dispatcher(
+        [this] {
+          set_ready(virtual_hid_keyboard_ready_,
+                    virtual_hid_keyboard_started_);
+        },
+        pqrs::dispatcher::priority::low);
+  }
+
+  void async_virtual_hid_keyboard_reset() const override {
+    enqueue_to_report_strand([this] {
+      if (virtual_hid_keyboard_started_) {
+        report_sink_->push(log_label_,
+                           pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_reset,
+                           {});
+      }
+    });
+  }
+
+  void async_virtual_hid_pointing_initialize() const override {
+    enqueue_to_report_strand([this] {
+      start_device(virtual_hid_pointing_started_);
+    });
+  }
+
+  void async_virtual_hid_pointing_ready() override {
+    enqueue_to_dispatcher(
+        [this] {
+          set_ready(virtual_hid_pointing_ready_,
+                    virtual_hid_pointing_started_);
+        },
+        pqrs::dispatcher::priority::low);
+  }
+
+  void async_virtual_hid_pointing_reset() const override {
+    enqueue_to_report_strand([this] {
+      if (virtual_hid_pointing_started_) {
+        report_sink_->push(log_label_,
+                           pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_reset,
+                           {});
+      }
+    });
+  }
+
+  void async_post_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+                         std::shared_ptr<std::vector<uint8_t>> report_buffer,
+                         size_t report_offset,
+                         size_t report_size,
+                         const char* report_name,
+                         pqrs::dispatcher::basic_task<void(bool)> posted = nullptr) const override {
+    enqueue_to_report_strand([this, user_client_method, report_buffer, report_offset, report_size, posted = std::move(posted)] mutable {
+      auto success = report_buffer &&
+                     report_offset <= report_buffer->size() &&
+                     report_size <= report_buffer->size() - report_offset &&
+                     device_started(user_client_method);
+
+      if (success) {
+        report_sink_->push(log_label_,
+                           user_client_method,
+                           std::span<const uint8_t>(report_buffer->data() + report_offset, report_size));
+      }
+
+      if (posted) {
+        posted(success);
+      }
+    });
+  }
+
+private:
+  // This method is executed in the report strand.
+  void start_device(std::atomic<bool>& started) const {
+    if (!started.exchange(true)) {
+      // The driver registers a started device, and `device_monitor` notifies it.
+      (*device_changed_)();
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void set_ready(std::optional<bool>& ready,
+                 const std::atomic<bool>& started) {
+    std::optional<bool> value;
+    if (connected_) {
+      value = started.load();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(ready_mutex_);
+
+      if (ready == value) {
+        return;
+      }
+
+      ready = value;
+    }
+
+    enqueue_to_dispatcher(
+        [this] {
+          state_changed();
+        },
+        pqrs::dispatcher::priority::low);
+  }
+
+  // This method is executed in the report strand.
+  bool device_started(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method) const {
+    switch (user_client_method) {
+      case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report:
+        return virtual_hid_keyboard_started_;
+      case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_post_report:
+        return virtual_hid_pointing_started_;
+      default:
+        return false;
+    }
+  }
+
+  std::string log_label_;
+  pqrs::not_null_shared_ptr_t<loopback_report_sink> report_sink_;
+  pqrs::not_null_shared_ptr_t<nod::signal<void()>> device_changed_;
+
+  std::atomic<bool> connected_;
+  mutable std::atomic<bool> virtual_hid_keyboard_started_;
+  mutable std::atomic<bool> virtual_hid_pointing_started_;
+
+  mutable std::mutex ready_mutex_;
+  std::optional<bool> virtual_hid_keyboard_ready_;
+  std::optional<bool> virtual_hid_pointing_ready_;
+};
+
+// `loopback_device_monitor` notifies that loopback devices are started.
+class loopback_device_monitor final : public device_monitor {
+public:
+  loopback_device_monitor(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                          pqrs::not_null_shared_ptr_t<nod::signal<void()>> device_changed)
+      : device_monitor(weak_dispatcher),
+        device_changed_(device_changed) {
+  }
+
+  ~loopback_device_monitor() override {
+    connection_.disconnect();
+
+    detach_from_dispatcher();
+  }
+
+  void async_start() override {
+    connection_ = device_changed_->connect([this] {
+      enqueue_to_dispatcher([this] {
+        device_changed();
+      });
+    });
+  }
+
+private:
+  pqrs::not_null_shared_ptr_t<nod::signal<void()>> device_changed_;
+  nod::connection connection_;
+};
+
+class loopback_driver_backend final : public driver_backend {
+public:
+  explicit loopback_driver_backend(pqrs::not_null_shared_ptr_t<loopback_report_sink> report_sink = std::make_shared<loopback_report_sink>())
+      : report_sink_(report_sink),
+        device_changed_(std::make_shared<nod::signal<void()>>()) {
+  }
+
+  pqrs::not_null_shared_ptr_t<loopback_report_sink> get_report_sink() const {
+    return report_sink_;
+  }
+
+  std::shared_ptr<driver_client> make_driver_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                                                    const std::string& log_label,
+                                                    std::optional<report_worker_pool::strand> report_strand) override {
+    return driver_client::make<loopback_driver_client>(weak_dispatcher,
+                                                       log_label,
+                                                       report_strand,
+                                                       report_sink_,
+                                                       device_changed_);
+  }
+
+  std::unique_ptr<device_monitor> make_device_monitor(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher) override {
+    return std::make_unique<loopback_device_monitor>(weak_dispatcher,
+                                                     device_changed_);
+  }
+
+private:
+  pqrs::not_null_shared_ptr_t<loopback_report_sink> report_sink_;
+  // `device_changed_` is signaled in the dispatcher thread when a loopback device is started.
+  pqrs::not_null_shared_ptr_t<nod::signal<void()>> device_changed_;
+};
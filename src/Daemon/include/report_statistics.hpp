@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+
+// `report_statistics` accumulates the report counters of a peer for `request::get_statistics`.
+//
+// The counters are relaxed atomics, so counting a report does not take a lock.
+// `get_statistics` loads them one by one, so the result is not a consistent snapshot while reports are being posted.
+//
+// Forward latencies are recorded in a histogram whose buckets split each power of two into 4,
+// so p99 is reported with at most 25% error without keeping each sample.
+// The histogram is guarded by `mutex_`.
+//
+// This class is thread-safe. `forwarded` is called in the report strand of the peer.
+class report_statistics final {
+public:
+  // A counter of `statistics`. Each post report row of the request table of the server holds its counter.
+  using counter = uint64_t pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::*;
+
+  void received(counter received_reports_counter) {
+    for (size_t i = 0; i < received_counters.size(); ++i) {
+      if (received_counters[i] == received_reports_counter) {
+        received_reports_[i].fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  void received_through_report_ring() {
+    received_report_ring_reports_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void dropped_by_size_error() {
+    dropped_reports_by_size_error_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void dropped_by_missing_device() {
+    dropped_reports_by_missing_device_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void forwarded(bool success,
+                 std::chrono::nanoseconds latency) {
+    forwarded_reports_.fetch_add(1, std::memory_order_relaxed);
+
+    if (!success) {
+      backend_errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto value = static_cast<uint64_t>(std::max(latency.count(), std::chrono::nanoseconds::rep(0)));
+
+    latency_sum_.fetch_add(value, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    min_latency_ = (latency_count_ == 0)
+                       ? value
+                       : std::min(min_latency_, value);
+    max_latency_ = std::max(max_latency_, value);
+    ++latency_count_;
+    ++histogram_[bucket_index(value)];
+  }
+
+  pqrs::karabiner::driverkit::virtual_hid_device_service::statistics get_statistics() const {
+    pqrs::karabiner::driverkit::virtual_hid_device_service::statistics result{};
+
+    for (size_t i = 0; i < received_counters.size(); ++i) {
+      result.*received_counters[i] = received_reports_[i].load(std::memory_order_relaxed);
+    }
+    result.received_report_ring_reports = received_report_ring_reports_.load(std::memory_order_relaxed);
+    result.forwarded_reports = forwarded_reports_.load(std::memory_order_relaxed);
+    result.dropped_reports_by_size_error = dropped_reports_by_size_error_.load(std::memory_order_relaxed);
+    result.dropped_reports_by_missing_device = dropped_reports_by_missing_device_.load(std::memory_order_relaxed);
+    result.backend_errors = backend_errors_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (latency_count_ > 0) {
+      // `latency_sum_` may include a sample which is not in the histogram yet.
+      result.min_forward_latency = min_latency_;
+      result.mean_forward_latency = latency_sum_.load(std::memory_order_relaxed) / latency_count_;
+      result.p99_forward_latency = percentile(99);
+    }
+
+    return result;
+  }
+
+private:
+  static constexpr size_t sub_bucket_bits = 2;
+  static constexpr size_t sub_bucket_count = 1 << sub_bucket_bits;
+  static constexpr size_t bucket_count = 64 * sub_bucket_count;
+
+  // Values below `sub_bucket_count` have their own bucket; larger values are grouped by
+  // the most significant bit and the following `sub_bucket_bits` bits.
+  static size_t bucket_index(uint64_t value) {
+    if (value < sub_bucket_count) {
+      return value;
+    }
+
+    auto msb = std::bit_width(value) - 1;
+    auto sub = (value >> (msb - sub_bucket_bits)) & (sub_bucket_count - 1);
+    return (msb - sub_bucket_bits + 1) * sub_bucket_count + sub;
+  }
+
+  // Returns the largest value in the bucket.
+  static uint64_t bucket_upper_bound(size_t index) {
+    if (index < sub_bucket_count) {
+      return index;
+    }
+
+    auto msb = index / sub_bucket_count + sub_bucket_bits - 1;
+    auto sub = index % sub_bucket_count;
+    auto lower = (uint64_t(1) << msb) | (uint64_t(sub) << (msb - sub_bucket_bits));
+    return lower + (uint64_t(1) << (msb - sub_bucket_bits)) - 1;
+  }
+
+  uint64_t percentile(uint64_t percent) const {
+    // The rank of the sample, rounded up.
+    auto rank = (latency_count_ * percent + 99) / 100;
+
+    uint64_t count = 0;
+    for (size_t i = 0; i < histogram_.size(); ++i) {
+      count += histogram_[i];
+      if (count >= rank) {
+        // The bucket bound may exceed the observed samples.
+        return std::min(bucket_upper_bound(i), max_latency_);
+      }
+    }
+
+    return max_latency_;
+  }
+
+  // The counters of `statistics` which `received` accepts.
+  static constexpr std::array<counter, 6> received_counters{
+      &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_keyboard_input_reports,
+      &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_consumer_input_reports,
+      &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_apple_vendor_keyboard_input_reports,
+      &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_apple_vendor_top_case_input_reports,
+      &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_generic_desktop_input_reports,
+      &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_pointing_input_reports,
+  };
+
+  std::array<std::atomic<uint64_t>, received_counters.size()> received_reports_{};
+  std::atomic<uint64_t> received_report_ring_reports_ = 0;
+  std::atomic<uint64_t> forwarded_reports_ = 0;
+  std::atomic<uint64_t> dropped_reports_by_size_error_ = 0;
+  std::atomic<uint64_t> dropped_reports_by_missing_device_ = 0;
+  std::atomic<uint64_t> backend_errors_ = 0;
+  std::atomic<uint64_t> latency_sum_ = 0;
+
+  mutable std::mutex mutex_;
+  uint64_t latency_count_ = 0;
+  uint64_t min_latency_ = 0;
+  uint64_t max_latency_ = 0;
+  std::array<uint64_t, bucket_count> histogram_{};
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <asio.hpp>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <pqrs/unix_domain_stream/impl/handler_memory.hpp>
+
+// `report_worker_pool` runs the report path of peers on a small pool of worker threads.
+//
+// Each peer gets its own strand.
+// Functions posted to a strand are executed in order and never concurrently,
+// so the reports of a peer are passed to the driver in the received order
+// while a slow driver call of a peer does not delay the reports of other peers.
+class report_worker_pool final {
+private:
+  // The functions are posted from the dispatcher thread and freed in worker threads,
+  // so their memory is recycled by `handler_memory` instead of asio's thread local cache.
+  using handler_memory = pqrs::unix_domain_stream::impl::handler_memory;
+
+  template <typename T>
+  using handler_allocator = pqrs::unix_domain_stream::impl::handler_allocator<T>;
+
+public:
+  class strand final {
+  public:
+    strand(asio::strand<asio::thread_pool::executor_type> executor,
+           handler_memory& memory)
+        : executor_(executor),
+          memory_(&memory) {
+    }
+
+    // Post `function` to be executed after the functions posted before.
+    template <typename F>
+    void post(F&& function) const {
+      asio::post(executor_,
+                 asio::bind_allocator(handler_allocator<void>(*memory_),
+                                      std::forward<F>(function)));
+    }
+
+  private:
+    asio::strand<asio::thread_pool::executor_type> executor_;
+    handler_memory* memory_;
+  };
+
+  report_worker_pool(const report_worker_pool&) = delete;
+
+  explicit report_worker_pool(size_t thread_count)
+      : thread_pool_(thread_count) {
+  }
+
+  ~report_worker_pool() {
+    // Finish the posted functions before the threads are stopped.
+    thread_pool_.join();
+  }
+
+  strand make_strand() {
+    return strand(asio::make_strand(thread_pool_.get_executor()),
+                  handler_memory_);
+  }
+
+  // Wait until the functions which are posted to `strand` before this call are finished.
+  // This method must not be called in the worker threads.
+  static void wait(const strand& strand) {
+    std::promise<void> promise;
+    strand.post([&promise] {
+      promise.set_value();
+    });
+    promise.get_future().wait();
+  }
+
+private:
+  // `handler_memory_` must outlive `thread_pool_`.
+  handler_memory handler_memory_;
+  asio::thread_pool thread_pool_;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "logger.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <string>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <launch.h>
+#endif
+
+// `socket_activation` returns the listening socket which is passed by the service manager.
+//
+// With socket activation, the service manager binds the server socket before the daemon starts,
+// and starts the daemon on the first client connection.
+// Clients can connect while the daemon is starting or restarting, so they do not wait for the bind retry and reconnect intervals.
+class socket_activation final {
+public:
+  // The name of the socket in the `Sockets` dictionary of the launchd plist.
+  static constexpr const char* launchd_socket_name = "Listeners";
+
+  // The first file descriptor passed by systemd `LISTEN_FDS`.
+  static constexpr int listen_fds_start = 3;
+
+  // Returns std::nullopt if the daemon is not started by socket activation.
+  // Call this only once since the passed sockets are consumed.
+  static std::optional<int> get_listening_socket() {
+#ifdef __APPLE__
+    int* fds = nullptr;
+    size_t count = 0;
+    auto error = launch_activate_socket(launchd_socket_name, &fds, &count);
+    if (error != 0) {
+      // ESRCH: The daemon is not managed by launchd.
+      // ENOENT: The socket is not declared in the plist.
+      if (error != ESRCH && error != ENOENT) {
+        logger::get_logger()->error("socket_activation launch_activate_socket error: {0}",
+                                    std::strerror(error));
+      }
+      return std::nullopt;
+    }
+
+    std::optional<int> result;
+    for (size_t i = 0; i < count; ++i) {
+      if (!result) {
+        result = fds[i];
+      } else {
+        close(fds[i]);
+      }
+    }
+    free(fds);
+
+    return result;
+#else
+    auto listen_pid = std::getenv("LISTEN_PID");
+    auto listen_fds = std::getenv("LISTEN_FDS");
+    if (!listen_pid ||
+        !listen_fds ||
+        std::strtoll(listen_pid, nullptr, 10) != getpid()) {
+      return std::nullopt;
+    }
+
+    auto count = std::strtol(listen_fds, nullptr, 10);
+
+    // Do not pass the sockets to child processes.
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+    unsetenv("LISTEN_FDNAMES");
+
+    if (count < 1) {
+      return std::nullopt;
+    }
+
+    for (int fd = listen_fds_start; fd < listen_fds_start + count; ++fd) {
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+      if (fd != listen_fds_start) {
+        close(fd);
+      }
+    }
+
+    return listen_fds_start;
+#endif
+  }
+};
@@ -0,0 +1,456 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// The events which are written into `trace_log`.
+// Add new events at the end since the values are written into trace files.
+enum class trace_event : uint16_t {
+  none,
+  // The trace buffer of a thread was full, and events were dropped.
+  events_dropped,
+  peer_connected,
+  peer_closed,
+  peer_error_occurred,
+  request_received,
+  report_forwarded,
+  report_dropped,
+  status_delivery_failed,
+};
+
+enum class trace_report_drop_reason : uint8_t {
+  size_error,
+  missing_device,
+};
+
+// The format of each event.
+// `{0}`...`{3}` are replaced with the arguments by `trace_log::format`.
+struct trace_event_definition final {
+  trace_event event;
+  std::string_view name;
+  std::string_view format;
+};
+
+constexpr std::array trace_event_definitions{
+    trace_event_definition{trace_event::none, "none", ""},
+    trace_event_definition{trace_event::events_dropped, "events_dropped", "thread:{0} count:{1}"},
+    trace_event_definition{trace_event::peer_connected, "peer_connected", "peer_id:{0} pid:{1} uid:{2}"},
+    trace_event_definition{trace_event::peer_closed, "peer_closed", "peer_id:{0}"},
+    trace_event_definition{trace_event::peer_error_occurred, "peer_error_occurred", "peer_id:{0} error:{1}"},
+    trace_event_definition{trace_event::request_received, "request_received", "peer_id:{0} request:{1}"},
+    trace_event_definition{trace_event::report_forwarded, "report_forwarded", "peer_id:{0} request:{1} success:{2} latency_ns:{3}"},
+    trace_event_definition{trace_event::report_dropped, "report_dropped", "peer_id:{0} request:{1} reason:{2}"},
+    trace_event_definition{trace_event::status_delivery_failed, "status_delivery_failed", "peer_id:{0} error:{1}"},
+};
+
+static_assert([] {
+  for (size_t i = 0; i < trace_event_definitions.size(); ++i) {
+    if (std::to_underlying(trace_event_definitions[i].event) != i) {
+      return false;
+    }
+  }
+  return true;
+}());
+
+// `trace_log` writes events as fixed-size binary records with their raw arguments.
+//
+// Each thread writes records into its own lock-free buffer, so writing an event does neither formatting, locking nor system calls.
+// A background thread appends the buffered records to the file periodically.
+// Events are dropped while the buffer of the thread is full, and the number of dropped events is written as `trace_event::events_dropped`.
+//
+// `tools/trace-decoder` renders the file as text or JSON.
+class trace_log final {
+public:
+  static constexpr uint32_t magic = 0x76687472; // "vhtr"
+  static constexpr uint32_t version = 1;
+  static constexpr size_t max_argument_count = 4;
+
+  // The number of records which each thread can buffer.
+  static constexpr size_t thread_buffer_capacity = 8192;
+  static constexpr auto flush_interval = std::chrono::milliseconds(10);
+
+  struct entry final {
+    // steady_clock time in nanoseconds.
+    uint64_t timestamp;
+    // system_clock time in nanoseconds since the epoch, which is estimated from `timestamp`.
+    uint64_t system_timestamp;
+    uint32_t thread_index;
+    trace_event event;
+    std::vector<uint64_t> arguments;
+  };
+
+  trace_log(const trace_log&) = delete;
+
+  ~trace_log() {
+    {
+      std::lock_guard<std::mutex> lock(flush_mutex_);
+      exit_ = true;
+    }
+    flush_cv_.notify_one();
+
+    flush_thread_.join();
+
+    flush();
+
+    close(fd_);
+  }
+
+  // Create a new trace file for writing.
+  // An existing file at `path` is kept as `get_previous_file_path(path)`, and the file is rotated in the same way when it exceeds `max_file_size`.
+  // Returns nullptr if the file cannot be created.
+  static std::unique_ptr<trace_log> create(const std::filesystem::path& path,
+                                           size_t max_file_size) {
+    auto fd = open_file(path);
+    if (fd < 0) {
+      return nullptr;
+    }
+
+    return std::unique_ptr<trace_log>(new trace_log(path, max_file_size, fd));
+  }
+
+  static std::filesystem::path get_previous_file_path(const std::filesystem::path& path) {
+    auto result = path;
+    result += ".previous";
+    return result;
+  }
+
+  // This method can be called from any thread.
+  template <typename... Arguments>
+  void write(trace_event event,
+             Arguments... arguments) noexcept {
+    static_assert(sizeof...(Arguments) <= max_argument_count);
+
+    auto buffer = get_thread_buffer();
+    if (!buffer) {
+      return;
+    }
+
+    auto head = buffer->head.load(std::memory_order_relaxed);
+    if (head - buffer->tail.load(std::memory_order_acquire) == thread_buffer_capacity) {
+      buffer->dropped_count.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    auto& r = buffer->records[head % thread_buffer_capacity];
+    r.timestamp = to_nanoseconds(std::chrono::steady_clock::now().time_since_epoch());
+    r.thread_index = buffer->thread_index;
+    r.event = event;
+    r.argument_count = sizeof...(Arguments);
+    r.arguments = {to_argument(arguments)...};
+
+    buffer->head.store(head + 1, std::memory_order_release);
+  }
+
+  // Returns the records sorted by the timestamp, or std::nullopt if the file is not a trace file.
+  static std::optional<std::vector<entry>> read(const std::filesystem::path& path) {
+    std::vector<uint8_t> buffer;
+
+    {
+      auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        return std::nullopt;
+      }
+
+      struct stat st;
+      if (fstat(fd, &st) == 0 &&
+          static_cast<size_t>(st.st_size) >= sizeof(header)) {
+        buffer.resize(st.st_size);
+        if (pread(fd, buffer.data(), buffer.size(), 0) != static_cast<ssize_t>(buffer.size())) {
+          buffer.clear();
+        }
+      }
+      close(fd);
+    }
+
+    if (buffer.empty()) {
+      return std::nullopt;
+    }
+
+    header h;
+    std::memcpy(&h, buffer.data(), sizeof(h));
+    if (h.magic != magic ||
+        h.version != version ||
+        h.record_size != sizeof(record)) {
+      return std::nullopt;
+    }
+
+    std::vector<entry> entries;
+
+    // A partially written record at the end is ignored.
+    for (size_t offset = sizeof(header); offset + sizeof(record) <= buffer.size(); offset += sizeof(record)) {
+      record r;
+      std::memcpy(&r, buffer.data() + offset, sizeof(r));
+
+      entries.push_back(entry{
+          .timestamp = r.timestamp,
+          .system_timestamp = h.system_clock_origin + (r.timestamp - h.steady_clock_origin),
+          .thread_index = r.thread_index,
+          .event = r.event,
+          .arguments = std::vector<uint64_t>(std::begin(r.arguments),
+                                             std::begin(r.arguments) + std::min<size_t>(r.argument_count, max_argument_count)),
+      });
+    }
+
+    std::ranges::stable_sort(entries, {}, &entry::timestamp);
+
+    return entries;
+  }
+
+  // Returns the event name and the formatted arguments. (e.g., "request_received peer_id:1 request:5")
+  static std::string format(const entry& e) {
+    auto index = std::to_underlying(e.event);
+    if (index >= trace_event_definitions.size()) {
+      std::string result = "unknown:" + std::to_string(index);
+      for (auto a : e.arguments) {
+        result += " " + std::to_string(a);
+      }
+      return result;
+    }
+
+    const auto& definition = trace_event_definitions[index];
+
+    std::string result(definition.name);
+    if (!definition.format.empty()) {
+      result += ' ';
+    }
+
+    auto f = definition.format;
+    for (size_t i = 0; i < f.size(); ++i) {
+      if (f[i] == '{' &&
+          i + 2 < f.size() &&
+          f[i + 2] == '}') {
+        auto argument_index = static_cast<size_t>(f[i + 1] - '0');
+        if (argument_index < e.arguments.size()) {
+          result += std::to_string(e.arguments[argument_index]);
+        }
+        i += 2;
+      } else {
+        result += f[i];
+      }
+    }
+
+    return result;
+  }
+
+private:
+  struct header final {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+    // The clocks at the file creation, which are used to convert steady_clock timestamps into system_clock.
+    uint64_t steady_clock_origin;
+    uint64_t system_clock_origin;
+  };
+
+  struct record final {
+    uint64_t timestamp;
+    uint32_t thread_index;
+    trace_event event;
+    uint16_t argument_count;
+    std::array<uint64_t, max_argument_count> arguments;
+  };
+
+  static_assert(sizeof(record) == 48);
+  static_assert(std::is_trivially_copyable_v<record>);
+
+  // A single-producer single-consumer ring of the records of a thread.
+  // The thread writes records and the flush thread reads them.
+  struct thread_buffer final {
+    explicit thread_buffer(uint32_t thread_index)
+        : thread_index(thread_index) {
+    }
+
+    uint32_t thread_index;
+    std::atomic<uint64_t> head = 0;
+    std::atomic<uint64_t> tail = 0;
+    std::atomic<uint64_t> dropped_count = 0;
+    std::array<record, thread_buffer_capacity> records;
+  };
+
+  // The buffer of the current thread, which is valid while `trace_log_id` is the id of the trace_log.
+  struct thread_buffer_cache final {
+    uint64_t trace_log_id = 0;
+    thread_buffer* buffer = nullptr;
+  };
+
+  static uint64_t to_nanoseconds(std::chrono::nanoseconds value) {
+    return static_cast<uint64_t>(value.count());
+  }
+
+  template <typename T>
+  static uint64_t to_argument(T value) {
+    if constexpr (std::is_enum_v<T>) {
+      return static_cast<uint64_t>(std::to_underlying(value));
+    } else {
+      return static_cast<uint64_t>(value);
+    }
+  }
+
+  static uint64_t make_new_id() {
+    static std::atomic<uint64_t> last_id = 0;
+    return ++last_id;
+  }
+
+  static thread_buffer_cache& get_thread_buffer_cache() {
+    thread_local thread_buffer_cache cache;
+    return cache;
+  }
+
+  // Returns -1 if the file cannot be created.
+  static int open_file(const std::filesystem::path& path) {
+    std::error_code error_code;
+    if (std::filesystem::file_size(path, error_code) > 0) {
+      std::filesystem::rename(path, get_previous_file_path(path), error_code);
+    }
+    std::filesystem::remove(path, error_code);
+
+    auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) {
+      return -1;
+    }
+
+    header h{
+        .magic = magic,
+        .version = version,
+        .record_size = sizeof(record),
+        .reserved = 0,
+        .steady_clock_origin = to_nanoseconds(std::chrono::steady_clock::now().time_since_epoch()),
+        .system_clock_origin = to_nanoseconds(std::chrono::system_clock::now().time_since_epoch()),
+    };
+    if (::write(fd, &h, sizeof(h)) != static_cast<ssize_t>(sizeof(h))) {
+      close(fd);
+      return -1;
+    }
+
+    return fd;
+  }
+
+  trace_log(const std::filesystem::path& path,
+            size_t max_file_size,
+            int fd)
+      : id_(make_new_id()),
+        path_(path),
+        max_file_size_(max_file_size),
+        fd_(fd),
+        file_size_(sizeof(header)),
+        exit_(false) {
+    flush_thread_ = std::thread([this] {
+      std::unique_lock<std::mutex> lock(flush_mutex_);
+
+      while (!exit_) {
+        flush_cv_.wait_for(lock, flush_interval, [this] {
+          return exit_;
+        });
+
+        lock.unlock();
+        flush();
+        lock.lock();
+      }
+    });
+  }
+
+  thread_buffer* get_thread_buffer() noexcept {
+    auto& cache = get_thread_buffer_cache();
+    if (cache.trace_log_id == id_) {
+      return cache.buffer;
+    }
+
+    // Register a buffer for the thread on the first event.
+    try {
+      std::lock_guard<std::mutex> lock(buffers_mutex_);
+
+      buffers_.push_back(std::make_unique<thread_buffer>(static_cast<uint32_t>(buffers_.size())));
+
+      cache.trace_log_id = id_;
+      cache.buffer = buffers_.back().get();
+      return cache.buffer;
+    } catch (...) {
+      return nullptr;
+    }
+  }
+
+  // This method is executed in the flush thread, or in the destructor after the flush thread is finished.
+  void flush() {
+    write_buffer_.clear();
+
+    {
+      std::lock_guard<std::mutex> lock(buffers_mutex_);
+
+      for (auto&& b : buffers_) {
+        auto tail = b->tail.load(std::memory_order_relaxed);
+        auto head = b->head.load(std::memory_order_acquire);
+
+        for (auto i = tail; i < head; ++i) {
+          write_buffer_.push_back(b->records[i % thread_buffer_capacity]);
+        }
+
+        b->tail.store(head, std::memory_order_release);
+
+        if (auto dropped_count = b->dropped_count.exchange(0, std::memory_order_relaxed)) {
+          write_buffer_.push_back(record{
+              .timestamp = to_nanoseconds(std::chrono::steady_clock::now().time_since_epoch()),
+              .thread_index = b->thread_index,
+              .event = trace_event::events_dropped,
+              .argument_count = 2,
+              .arguments = {b->thread_index, dropped_count},
+          });
+        }
+      }
+    }
+
+    if (write_buffer_.empty()) {
+      return;
+    }
+
+    auto size = write_buffer_.size() * sizeof(record);
+
+    if (file_size_ + size > max_file_size_) {
+      auto fd = open_file(path_);
+      if (fd >= 0) {
+        close(fd_);
+        fd_ = fd;
+        file_size_ = sizeof(header);
+      }
+    }
+
+    if (::write(fd_, write_buffer_.data(), size) == static_cast<ssize_t>(size)) {
+      file_size_ += size;
+    }
+  }
+
+  uint64_t id_;
+  std::filesystem::path path_;
+  size_t max_file_size_;
+
+  // `fd_`, `file_size_` and `write_buffer_` are used only in `flush`.
+  int fd_;
+  size_t file_size_;
+  std::vector<record> write_buffer_;
+
+  std::mutex buffers_mutex_;
+  std::vector<std::unique_ptr<thread_buffer>> buffers_;
+
+  std::thread flush_thread_;
+  std::mutex flush_mutex_;
+  std::condition_variable flush_cv_;
+  bool exit_;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "driver_backend.hpp"
+#include "logger.hpp"
+#include <IOKit/IOKitLib.h>
+#include <memory>
+#include <pqrs/cf/cf_ptr.hpp>
+#include <pqrs/cf/string.hpp>
+#include <pqrs/dispatcher.hpp>
+#include <pqrs/osx/iokit_service_monitor.hpp>
+
+// `virtual_hid_device_monitor` observes the virtual HID devices in the IORegistry.
+//
+// A virtual HID device is registered after the driver marks it as ready,
+// so `device_changed` is signaled as soon as a device is started or terminated.
+class virtual_hid_device_monitor final : public device_monitor {
+public:
+  virtual_hid_device_monitor(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                             pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread)
+      : device_monitor(weak_dispatcher),
+        run_loop_thread_(run_loop_thread) {
+  }
+
+  ~virtual_hid_device_monitor() override {
+    detach_from_dispatcher([this] {
+      virtual_hid_keyboard_monitor_ = nullptr;
+      virtual_hid_pointing_monitor_ = nullptr;
+    });
+  }
+
+  void async_start() override {
+    enqueue_to_dispatcher([this] {
+      virtual_hid_keyboard_monitor_ = make_service_monitor("org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard");
+      virtual_hid_pointing_monitor_ = make_service_monitor("org_pqrs_Karabiner_DriverKit_VirtualHIDPointing");
+    });
+  }
+
+private:
+  // This method is executed in the dispatcher thread.
+  std::unique_ptr<pqrs::osx::iokit_service_monitor> make_service_monitor(const char* user_class) {
+    auto matching_dictionary = pqrs::cf::adopt_cf_ptr(IOServiceMatching("IOHIDDevice"));
+    auto property_dictionary = pqrs::cf::adopt_cf_ptr(CFDictionaryCreateMutable(kCFAllocatorDefault,
+                                                                                0,
+                                                                                &kCFTypeDictionaryKeyCallBacks,
+                                                                                &kCFTypeDictionaryValueCallBacks));
+    auto user_class_string = pqrs::cf::make_cf_string(user_class);
+    if (!matching_dictionary ||
+        !property_dictionary ||
+        !user_class_string) {
+      logger::get_logger()->error("virtual_hid_device_monitor failed to create matching dictionary for {0}",
+                                  user_class);
+      enqueue_to_dispatcher([this] {
+        error_occurred();
+      });
+      return nullptr;
+    }
+
+    CFDictionarySetValue(*property_dictionary, CFSTR("IOUserClass"), *user_class_string);
+    CFDictionarySetValue(*matching_dictionary, CFSTR(kIOPropertyMatchKey), *property_dictionary);
+
+    auto monitor = std::make_unique<pqrs::osx::iokit_service_monitor>(weak_dispatcher_,
+                                                                      run_loop_thread_,
+                                                                      *matching_dictionary);
+
+    monitor->service_matched.connect([this, user_class](auto&& registry_entry_id, auto&& service_ptr) {
+      logger::get_logger()->debug("virtual_hid_device_monitor {0} is matched",
+                                  user_class);
+      device_changed();
+    });
+
+    monitor->service_terminated.connect([this, user_class](auto&& registry_entry_id) {
+      logger::get_logger()->debug("virtual_hid_device_monitor {0} is terminated",
+                                  user_class);
+      device_changed();
+    });
+
+    monitor->error_occurred.connect([this, user_class](auto&& message, auto&& kern_return) {
+      logger::get_logger()->error("virtual_hid_device_monitor {0} {1} {2}",
+                                  user_class,
+                                  message,
+                                  kern_return);
+      error_occurred();
+    });
+
+    monitor->async_start();
+
+    return monitor;
+  }
+
+  pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread_;
+  std::unique_ptr<pqrs::osx::iokit_service_monitor> virtual_hid_keyboard_monitor_;
+  std::unique_ptr<pqrs::osx::iokit_service_monitor> virtual_hid_pointing_monitor_;
+};
@@ -1,29 +1,86 @@
 #pragma once
 
+#include "log_limiter.hpp"
 #include "logger.hpp"
+#include "driver_backend.hpp"
+#include "report_statistics.hpp"
+#include "report_worker_pool.hpp"
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <filesystem>
 #include <memory>
 #include <nod/nod.hpp>
 #include <pqrs/dispatcher.hpp>
 #include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
 #include <pqrs/unix_domain_stream.hpp>
+#include <span>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 class virtual_hid_device_service_clients_manager final : public pqrs::dispatcher::extra::dispatcher_client {
 public:
+  // The report journal records forwarded reports for diagnosing stuck keys and latency issues afterwards.
+  // It is enabled when this file exists at startup. (e.g., `sudo touch /var/log/karabiner/virtual_hid_device_service_report_journal`)
+  static constexpr const char* report_journal_file_path = "/var/log/karabiner/virtual_hid_device_service_report_journal";
+  static constexpr uint32_t report_journal_record_count = 32768;
+
+  // Reports of each peer are passed to the driver in its own strand over these threads.
+  static constexpr size_t report_worker_thread_count = 4;
+
+  // The readiness of virtual HID devices is polled in this interval while it is being waited,
+  // or always when `device_monitor` is unavailable.
+  static constexpr auto ready_polling_interval = std::chrono::milliseconds(1000);
+
   nod::signal<void(pqrs::unix_domain_stream::peer_id, const std::vector<uint8_t>&)> status_changed;
 
   virtual_hid_device_service_clients_manager(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
-                                             pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread)
+                                             pqrs::not_null_shared_ptr_t<driver_backend> driver_backend)
       : dispatcher_client(weak_dispatcher),
-        run_loop_thread_(run_loop_thread) {
+        driver_backend_(driver_backend),
+        report_worker_pool_(report_worker_thread_count),
+        device_monitor_available_(true) {
+    std::error_code error_code;
+    if (std::filesystem::exists(report_journal_file_path, error_code)) {
+      report_journal_ = pqrs::karabiner::driverkit::virtual_hid_device_service::report_journal::create(report_journal_file_path,
+                                                                                                      report_journal_record_count);
+      if (report_journal_) {
+        logger::get_logger()->info("report journal is enabled: {0}",
+                                   report_journal_file_path);
+      } else {
+        logger::get_logger()->error("failed to create report journal: {0}",
+                                    report_journal_file_path);
+      }
+    }
+
+    device_monitor_ = driver_backend_->make_device_monitor(weak_dispatcher_);
+
+    device_monitor_->device_changed.connect([this] {
+      for (const auto& [peer_id, entry] : client_entries_) {
+        entry->async_check_ready();
+      }
+    });
+
+    device_monitor_->error_occurred.connect([this] {
+      if (!device_monitor_available_) {
+        return;
+      }
+
+      logger::get_logger()->warn("device_monitor is unavailable; fall back to polling the readiness");
+
+      device_monitor_available_ = false;
+      for (const auto& [peer_id, entry] : client_entries_) {
+        entry->set_device_monitor_available(false);
+      }
+    });
+
+    device_monitor_->async_start();
   }
 
   ~virtual_hid_device_service_clients_manager() override {
     detach_from_dispatcher([this] {
+      device_monitor_ = nullptr;
       client_entries_.clear();
     });
   }
@@ -44,8 +101,10 @@ public:
     }
 
     auto entry = std::make_unique<client_entry>(weak_dispatcher_,
-                                                run_loop_thread_,
-                                                log_label);
+                                                driver_backend_,
+                                                log_label,
+                                                report_worker_pool_.make_strand(),
+                                                device_monitor_available_);
 
     entry->status_changed.connect([this, peer_id](const auto& response) {
       status_changed(peer_id,
@@ -139,7 +198,7 @@ public:
 
     if (auto it = client_entries_.find(peer_id);
         it != client_entries_.end()) {
-      if (auto client = it->second->get_virtual_hid_keyboard_io_service_client()) {
+      if (auto client = it->second->get_virtual_hid_keyboard_driver_client()) {
         client->async_virtual_hid_keyboard_reset();
       }
     }
@@ -153,7 +212,7 @@ public:
 
     if (auto it = client_entries_.find(peer_id);
         it != client_entries_.end()) {
-      if (auto client = it->second->get_virtual_hid_pointing_io_service_client()) {
+      if (auto client = it->second->get_virtual_hid_pointing_driver_client()) {
         client->async_virtual_hid_pointing_reset();
       }
     }
@@ -173,39 +232,94 @@ public:
     return {};
   }
 
+  // This method needs to be called in the dispatcher thread.
+  std::vector<uint8_t> make_statistics_response(pqrs::unix_domain_stream::peer_id peer_id) const {
+    if (!dispatcher_thread()) {
+      throw std::logic_error(fmt::format("{0} is called in wrong thread", __func__));
+    }
+
+    pqrs::karabiner::driverkit::virtual_hid_device_service::statistics statistics{};
+
+    if (auto it = client_entries_.find(peer_id);
+        it != client_entries_.end()) {
+      statistics = it->second->get_report_statistics()->get_statistics();
+    }
+
+    return pqrs::karabiner::driverkit::virtual_hid_device_service::make_statistics_response(statistics);
+  }
+
+  // This method needs to be called in the dispatcher thread.
+  //
+  // Record a post report which is dropped before it reaches the manager since the report size is wrong.
+  void record_report_size_error(pqrs::unix_domain_stream::peer_id peer_id,
+                                report_statistics::counter received_reports_counter) const {
+    if (!dispatcher_thread()) {
+      throw std::logic_error(fmt::format("{0} is called in wrong thread", __func__));
+    }
+
+    if (auto it = client_entries_.find(peer_id);
+        it != client_entries_.end()) {
+      auto& statistics = *(it->second->get_report_statistics());
+      statistics.received(received_reports_counter);
+      statistics.dropped_by_size_error();
+    }
+  }
+
+  // This method needs to be called in the dispatcher thread.
+  //
+  // Record a post report which is drained from the report ring of the peer.
+  void record_report_ring_report(pqrs::unix_domain_stream::peer_id peer_id) const {
+    if (!dispatcher_thread()) {
+      throw std::logic_error(fmt::format("{0} is called in wrong thread", __func__));
+    }
+
+    if (auto it = client_entries_.find(peer_id);
+        it != client_entries_.end()) {
+      it->second->get_report_statistics()->received_through_report_ring();
+    }
+  }
+
   // This method needs to be called in the dispatcher thread.
   void post_keyboard_report(pqrs::unix_domain_stream::peer_id peer_id,
+                            pqrs::karabiner::driverkit::virtual_hid_device_service::request request_type,
+                            report_statistics::counter received_reports_counter,
                             std::shared_ptr<std::vector<uint8_t>> buffer,
                             size_t report_offset,
+                            size_t report_size,
                             pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
-                            const char* report_name,
-                            size_t expected_size) const {
+                            const char* report_name) const {
     post_report(peer_id,
+                request_type,
+                received_reports_counter,
                 std::move(buffer),
                 report_offset,
+                report_size,
                 user_client_method,
                 report_name,
-                expected_size,
                 [](const client_entry& client_entry) {
-                  return client_entry.get_virtual_hid_keyboard_io_service_client();
+                  return client_entry.get_virtual_hid_keyboard_driver_client();
                 });
   }
 
   // This method needs to be called in the dispatcher thread.
   void post_pointing_report(pqrs::unix_domain_stream::peer_id peer_id,
+                            pqrs::karabiner::driverkit::virtual_hid_device_service::request request_type,
+                            report_statistics::counter received_reports_counter,
                             std::shared_ptr<std::vector<uint8_t>> buffer,
                             size_t report_offset,
+                            size_t report_size,
                             pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
-                            const char* report_name,
-                            size_t expected_size) const {
+                            const char* report_name) const {
     post_report(peer_id,
+                request_type,
+                received_reports_counter,
                 std::move(buffer),
                 report_offset,
+                report_size,
                 user_client_method,
                 report_name,
-                expected_size,
                 [](const client_entry& client_entry) {
-                  return client_entry.get_virtual_hid_pointing_io_service_client();
+                  return client_entry.get_virtual_hid_pointing_driver_client();
                 });
   }
 
@@ -215,78 +329,78 @@ private:
     nod::signal<void(const std::vector<uint8_t>&)> status_changed;
 
     client_entry(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
-                 pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread,
-                 const std::string& log_label)
+                 pqrs::not_null_shared_ptr_t<driver_backend> driver_backend,
+                 const std::string& log_label,
+                 report_worker_pool::strand report_strand,
+                 bool device_monitor_available)
         : dispatcher_client(weak_dispatcher),
-          run_loop_thread_(run_loop_thread),
+          driver_backend_(driver_backend),
           log_label_(log_label),
-          ready_timer_(*this),
+          report_strand_(report_strand),
+          report_statistics_(std::make_shared<report_statistics>()),
+          ready_timer_(*this, pqrs::dispatcher::priority::low),
+          device_monitor_available_(device_monitor_available),
           virtual_hid_keyboard_client_generation_id_(0),
           virtual_hid_keyboard_enabled_(false),
           virtual_hid_pointing_client_generation_id_(0),
           virtual_hid_pointing_enabled_(false) {
-      no_virtual_devices_io_service_client_ = std::make_shared<io_service_client>(weak_dispatcher_,
-                                                                                  run_loop_thread_,
-                                                                                  log_label);
+      no_virtual_devices_driver_client_ = driver_backend_->make_driver_client(weak_dispatcher_,
+                                                                              log_label);
 
-      no_virtual_devices_io_service_client_->opened.connect([] {
+      no_virtual_devices_driver_client_->opened.connect([] {
         // Do nothing
       });
 
-      no_virtual_devices_io_service_client_->closed.connect([] {
+      no_virtual_devices_driver_client_->closed.connect([] {
         // Do nothing
       });
 
-      no_virtual_devices_io_service_client_->state_changed.connect([this] {
+      no_virtual_devices_driver_client_->state_changed.connect([this] {
         check_status_changed();
       });
 
-      no_virtual_devices_io_service_client_->async_start();
+      no_virtual_devices_driver_client_->async_start();
 
-      ready_timer_.start(
+      enqueue_to_dispatcher(
           [this] {
-            //
-            // Query `ready` state to driver
-            //
-
-            if (auto client = virtual_hid_keyboard_io_service_client_) {
-              client->async_virtual_hid_keyboard_ready();
-            }
-            if (auto client = virtual_hid_pointing_io_service_client_) {
-              client->async_virtual_hid_pointing_ready();
-            }
+            update_ready_timer();
           },
-          std::chrono::milliseconds(1000));
+          pqrs::dispatcher::priority::low);
     }
 
     ~client_entry() {
       detach_from_dispatcher([this] {
-        virtual_hid_pointing_io_service_client_ = nullptr;
-        virtual_hid_keyboard_io_service_client_ = nullptr;
-        no_virtual_devices_io_service_client_ = nullptr;
+        virtual_hid_pointing_driver_client_ = nullptr;
+        virtual_hid_keyboard_driver_client_ = nullptr;
+        no_virtual_devices_driver_client_ = nullptr;
       });
     }
 
-    std::shared_ptr<io_service_client> get_virtual_hid_keyboard_io_service_client() const {
-      return virtual_hid_keyboard_io_service_client_;
+    std::shared_ptr<driver_client> get_virtual_hid_keyboard_driver_client() const {
+      return virtual_hid_keyboard_driver_client_;
+    }
+
+    std::shared_ptr<driver_client> get_virtual_hid_pointing_driver_client() const {
+      return virtual_hid_pointing_driver_client_;
     }
 
-    std::shared_ptr<io_service_client> get_virtual_hid_pointing_io_service_client() const {
-      return virtual_hid_pointing_io_service_client_;
+    // The statistics is shared with the callbacks of posted reports.
+    pqrs::not_null_shared_ptr_t<report_statistics> get_report_statistics() const {
+      return report_statistics_;
     }
 
     //
-    // virtual_hid_keyboard_io_service_client_
+    // virtual_hid_keyboard_driver_client_
     //
 
     void initialize_keyboard(const pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters& parameters) {
       enqueue_to_dispatcher([this, parameters] {
-        // Destroy virtual_hid_keyboard_io_service_client_ if parameters is changed.
-        if (virtual_hid_keyboard_io_service_client_ &&
+        // Destroy virtual_hid_keyboard_driver_client_ if parameters is changed.
+        if (virtual_hid_keyboard_driver_client_ &&
             virtual_hid_keyboard_parameters_ != parameters) {
-          logger::get_logger()->debug("destroy virtual_hid_keyboard_io_service_client_ due to parameter changes");
+          logger::get_logger()->debug("destroy virtual_hid_keyboard_driver_client_ due to parameter changes");
 
-          virtual_hid_keyboard_io_service_client_ = nullptr;
+          virtual_hid_keyboard_driver_client_ = nullptr;
         }
 
         virtual_hid_keyboard_enabled_ = true;
@@ -302,14 +416,14 @@ private:
         virtual_hid_keyboard_enabled_ = false;
 
         ++virtual_hid_keyboard_client_generation_id_;
-        virtual_hid_keyboard_io_service_client_ = nullptr;
+        virtual_hid_keyboard_driver_client_ = nullptr;
 
         check_status_changed();
       });
     }
 
     //
-    // virtual_hid_pointing_io_service_client_
+    // virtual_hid_pointing_driver_client_
     //
 
     void initialize_pointing() {
@@ -326,16 +440,37 @@ private:
         virtual_hid_pointing_enabled_ = false;
 
         ++virtual_hid_pointing_client_generation_id_;
-        virtual_hid_pointing_io_service_client_ = nullptr;
+        virtual_hid_pointing_driver_client_ = nullptr;
 
         check_status_changed();
       });
     }
 
+    // Query `ready` state to driver.
+    // This method is called when virtual HID devices are started or terminated.
+    void async_check_ready() {
+      enqueue_to_dispatcher(
+          [this] {
+            check_ready();
+          },
+          pqrs::dispatcher::priority::low);
+    }
+
+    void set_device_monitor_available(bool value) {
+      enqueue_to_dispatcher(
+          [this, value] {
+            device_monitor_available_ = value;
+            update_ready_timer();
+          },
+          pqrs::dispatcher::priority::low);
+    }
+
     void async_check_status_changed() {
-      enqueue_to_dispatcher([this] {
-        check_status_changed();
-      });
+      enqueue_to_dispatcher(
+          [this] {
+            check_status_changed();
+          },
+          pqrs::dispatcher::priority::low);
     }
 
     std::vector<uint8_t> make_response() const {
@@ -344,9 +479,9 @@ private:
 
       std::ranges::for_each(
           std::array{
-              std::pair{response::driver_activated, no_virtual_devices_io_service_client_->driver_activated()},
-              std::pair{response::driver_connected, no_virtual_devices_io_service_client_->driver_connected()},
-              std::pair{response::driver_version_mismatched, no_virtual_devices_io_service_client_->driver_version_mismatched()},
+              std::pair{response::driver_activated, no_virtual_devices_driver_client_->driver_activated()},
+              std::pair{response::driver_connected, no_virtual_devices_driver_client_->driver_connected()},
+              std::pair{response::driver_version_mismatched, no_virtual_devices_driver_client_->driver_version_mismatched()},
               std::pair{response::virtual_hid_keyboard_ready, virtual_hid_keyboard_ready()},
               std::pair{response::virtual_hid_pointing_ready, virtual_hid_pointing_ready()},
           },
@@ -368,11 +503,11 @@ private:
 
       if (virtual_hid_keyboard_enabled_) {
         if (!virtual_hid_keyboard_ready() &&
-            !virtual_hid_keyboard_io_service_client_) {
+            !virtual_hid_keyboard_driver_client_) {
           create_virtual_hid_keyboard_client();
         }
       } else {
-        virtual_hid_keyboard_io_service_client_ = nullptr;
+        virtual_hid_keyboard_driver_client_ = nullptr;
       }
 
       //
@@ -381,18 +516,18 @@ private:
 
       if (virtual_hid_pointing_enabled_) {
         if (!virtual_hid_pointing_ready() &&
-            !virtual_hid_pointing_io_service_client_) {
+            !virtual_hid_pointing_driver_client_) {
           create_virtual_hid_pointing_client();
         }
       } else {
-        virtual_hid_pointing_io_service_client_ = nullptr;
+        virtual_hid_pointing_driver_client_ = nullptr;
       }
     }
 
     // This method is executed in the dispatcher thread.
     void create_virtual_hid_keyboard_client() {
       create_virtual_hid_client(
-          virtual_hid_keyboard_io_service_client_,
+          virtual_hid_keyboard_driver_client_,
           virtual_hid_keyboard_client_generation_id_,
           [this](auto client) {
             client->async_virtual_hid_keyboard_initialize(virtual_hid_keyboard_parameters_);
@@ -403,13 +538,13 @@ private:
           [this] {
             return virtual_hid_keyboard_ready();
           },
-          "recreate virtual_hid_keyboard_io_service_client_ since virtual_hid_keyboard is not ready");
+          "recreate virtual_hid_keyboard_driver_client_ since virtual_hid_keyboard is not ready");
     }
 
     // This method is executed in the dispatcher thread.
     void create_virtual_hid_pointing_client() {
       create_virtual_hid_client(
-          virtual_hid_pointing_io_service_client_,
+          virtual_hid_pointing_driver_client_,
           virtual_hid_pointing_client_generation_id_,
           [](auto client) {
             client->async_virtual_hid_pointing_initialize();
@@ -420,12 +555,12 @@ private:
           [this] {
             return virtual_hid_pointing_ready();
           },
-          "recreate virtual_hid_pointing_io_service_client_ since virtual_hid_pointing is not ready");
+          "recreate virtual_hid_pointing_driver_client_ since virtual_hid_pointing is not ready");
     }
 
     // This method is executed in the dispatcher thread.
     template <typename InitializeClient, typename IsEnabled, typename IsReady>
-    void create_virtual_hid_client(std::shared_ptr<io_service_client>& client,
+    void create_virtual_hid_client(std::shared_ptr<driver_client>& client,
                                    int& client_generation_id,
                                    InitializeClient initialize_client,
                                    IsEnabled is_enabled,
@@ -433,14 +568,14 @@ private:
                                    const char* recreate_log_message) {
       ++client_generation_id;
 
-      client = std::make_shared<io_service_client>(weak_dispatcher_,
-                                                   run_loop_thread_,
-                                                   log_label_);
+      client = driver_backend_->make_driver_client(weak_dispatcher_,
+                                                   log_label_,
+                                                   report_strand_);
       client->state_changed.connect([this] {
         check_status_changed();
       });
 
-      client->opened.connect([weak_client = std::weak_ptr<io_service_client>(client),
+      client->opened.connect([weak_client = std::weak_ptr<driver_client>(client),
                               initialize_client] {
         if (auto client = weak_client.lock()) {
           initialize_client(client);
@@ -473,6 +608,7 @@ private:
               setup_virtual_hid_devices();
             }
           },
+          pqrs::dispatcher::priority::low,
           when_now() + std::chrono::milliseconds(5000));
     }
 
@@ -480,8 +616,8 @@ private:
     bool virtual_hid_keyboard_ready() const {
       std::optional<bool> ready;
 
-      if (virtual_hid_keyboard_io_service_client_) {
-        ready = virtual_hid_keyboard_io_service_client_->get_virtual_hid_keyboard_ready();
+      if (virtual_hid_keyboard_driver_client_) {
+        ready = virtual_hid_keyboard_driver_client_->get_virtual_hid_keyboard_ready();
       }
 
       return ready.value_or(false);
@@ -491,8 +627,8 @@ private:
     bool virtual_hid_pointing_ready() const {
       std::optional<bool> ready;
 
-      if (virtual_hid_pointing_io_service_client_) {
-        ready = virtual_hid_pointing_io_service_client_->get_virtual_hid_pointing_ready();
+      if (virtual_hid_pointing_driver_client_) {
+        ready = virtual_hid_pointing_driver_client_->get_virtual_hid_pointing_ready();
       }
 
       return ready.value_or(false);
@@ -507,8 +643,45 @@ private:
                                   });
     }
 
+    // This method is executed in the dispatcher thread.
+    void check_ready() const {
+      if (auto client = virtual_hid_keyboard_driver_client_) {
+        client->async_virtual_hid_keyboard_ready();
+      }
+      if (auto client = virtual_hid_pointing_driver_client_) {
+        client->async_virtual_hid_pointing_ready();
+      }
+    }
+
+    // This method is executed in the dispatcher thread.
+    //
+    // The readiness is polled only while an enabled device is not ready yet,
+    // since `device_monitor` notifies device changes.
+    // The polling also covers devices which are started before the monitor observes them.
+    void update_ready_timer() {
+      auto waiting = (virtual_hid_keyboard_enabled_ && !virtual_hid_keyboard_ready()) ||
+                     (virtual_hid_pointing_enabled_ && !virtual_hid_pointing_ready());
+      auto polling = waiting || !device_monitor_available_;
+
+      if (polling == ready_timer_.enabled()) {
+        return;
+      }
+
+      if (polling) {
+        ready_timer_.start(
+            [this] {
+              check_ready();
+            },
+            ready_polling_interval);
+      } else {
+        ready_timer_.stop();
+      }
+    }
+
     // This method is executed in the dispatcher thread.
     void check_status_changed() {
+      update_ready_timer();
+
       auto response = make_response();
 
       if (last_response_ != response) {
@@ -517,13 +690,17 @@ private:
       }
     }
 
-    pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread_;
+    pqrs::not_null_shared_ptr_t<driver_backend> driver_backend_;
     std::string log_label_;
+    // The virtual_hid_keyboard and virtual_hid_pointing clients share the strand of the peer.
+    report_worker_pool::strand report_strand_;
 
-    std::shared_ptr<io_service_client> no_virtual_devices_io_service_client_;
-    std::shared_ptr<io_service_client> virtual_hid_keyboard_io_service_client_;
-    std::shared_ptr<io_service_client> virtual_hid_pointing_io_service_client_;
+    std::shared_ptr<driver_client> no_virtual_devices_driver_client_;
+    std::shared_ptr<driver_client> virtual_hid_keyboard_driver_client_;
+    std::shared_ptr<driver_client> virtual_hid_pointing_driver_client_;
+    pqrs::not_null_shared_ptr_t<report_statistics> report_statistics_;
     pqrs::dispatcher::extra::timer ready_timer_;
+    bool device_monitor_available_;
     std::optional<std::vector<uint8_t>> last_response_;
 
     // virtual_hid_keyboard
@@ -536,41 +713,88 @@ private:
     bool virtual_hid_pointing_enabled_;
   };
 
-  template <typename GetIoServiceClient>
+  template <typename GetDriverClient>
   void post_report(pqrs::unix_domain_stream::peer_id peer_id,
+                   pqrs::karabiner::driverkit::virtual_hid_device_service::request request_type,
+                   report_statistics::counter received_reports_counter,
                    std::shared_ptr<std::vector<uint8_t>> buffer,
                    size_t report_offset,
+                   size_t report_size,
                    pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
                    const char* report_name,
-                   size_t expected_size,
-                   GetIoServiceClient get_io_service_client) const {
+                   GetDriverClient get_driver_client) const {
     if (!dispatcher_thread()) {
       throw std::logic_error(fmt::format("{0} is called in wrong thread", __func__));
     }
 
+    auto it = client_entries_.find(peer_id);
+    if (it == client_entries_.end()) {
+      return;
+    }
+
+    auto statistics = it->second->get_report_statistics();
+    statistics->received(received_reports_counter);
+
     if (!buffer ||
-        report_offset > buffer->size()) {
-      logger::get_logger()->warn(fmt::format("{0}: buffer range error", __func__));
+        report_offset > buffer->size() ||
+        report_size > buffer->size() - report_offset) {
+      if (auto suppressed_count = report_error_log_limiter_.acquire()) {
+        logger::get_logger()->warn("{0}: buffer range error{1}",
+                                   __func__,
+                                   log_limiter::make_suppressed_message(*suppressed_count));
+      }
+      logger::trace(trace_event::report_dropped,
+                    peer_id,
+                    request_type,
+                    trace_report_drop_reason::size_error);
+      statistics->dropped_by_size_error();
       return;
     }
 
-    auto report_size = buffer->size() - report_offset;
-    if (expected_size != report_size) {
-      logger::get_logger()->warn(fmt::format("{0}: buffer size error", __func__));
+    auto client = get_driver_client(*(it->second));
+    if (!client) {
+      logger::trace(trace_event::report_dropped,
+                    peer_id,
+                    request_type,
+                    trace_report_drop_reason::missing_device);
+      statistics->dropped_by_missing_device();
       return;
     }
 
-    if (auto it = client_entries_.find(peer_id);
-        it != client_entries_.end()) {
-      if (auto client = get_io_service_client(*(it->second))) {
-        client->async_post_report(user_client_method,
-                                  std::move(buffer),
-                                  report_offset,
-                                  report_name);
-      }
+    auto received_time = std::chrono::steady_clock::now();
+
+    if (report_journal_) {
+      report_journal_->write(peer_id,
+                             request_type,
+                             std::span<const uint8_t>(buffer->data() + report_offset, report_size),
+                             received_time);
     }
+
+    client->async_post_report(user_client_method,
+                              std::move(buffer),
+                              report_offset,
+                              report_size,
+                              report_name,
+                              [statistics, received_time, peer_id, request_type](auto success) {
+                                auto latency = std::chrono::steady_clock::now() - received_time;
+
+                                statistics->forwarded(success,
+                                                      latency);
+
+                                logger::trace(trace_event::report_forwarded,
+                                              peer_id,
+                                              request_type,
+                                              success,
+                                              std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+                              });
   }
 
-  pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread_;
+  pqrs::not_null_shared_ptr_t<driver_backend> driver_backend_;
+  // `report_worker_pool_` must outlive `client_entries_`.
+  report_worker_pool report_worker_pool_;
   std::unordered_map<pqrs::unix_domain_stream::peer_id, std::unique_ptr<client_entry>> client_entries_;
+  std::unique_ptr<device_monitor> device_monitor_;
+  bool device_monitor_available_;
+  std::unique_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::report_journal> report_journal_;
+  mutable log_limiter report_error_log_limiter_;
 };
@@ -1,28 +1,45 @@
 #pragma once
 
+#include "log_limiter.hpp"
 #include "logger.hpp"
 #include "virtual_hid_device_service_clients_manager.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstring>
 #include <filesystem>
 #include <pqrs/dispatcher.hpp>
 #include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
 #include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
 #include <pqrs/unix_domain_stream.hpp>
+#include <optional>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 class virtual_hid_device_service_server final : public pqrs::dispatcher::extra::dispatcher_client {
 public:
-  virtual_hid_device_service_server(pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread)
+  // The parent directory of `socket_file_path` is created with the owner-only permission.
+  //
+  // If `listening_socket` is specified, the server accepts connections on it instead of binding `socket_file_path`.
+  // (`listening_socket` is a socket passed by the service manager. See `socket_activation`.)
+  explicit virtual_hid_device_service_server(pqrs::not_null_shared_ptr_t<driver_backend> driver_backend,
+                                             const std::filesystem::path& socket_file_path = pqrs::karabiner::driverkit::virtual_hid_device_service::constants::get_server_socket_file_path(),
+                                             std::optional<int> listening_socket = std::nullopt)
       : dispatcher_client(),
-        run_loop_thread_(run_loop_thread),
-        create_server_retry_timer_(*this) {
+        driver_backend_(driver_backend),
+        socket_file_path_(socket_file_path),
+        listening_socket_(listening_socket),
+        create_server_retry_timer_(*this),
+        report_ring_buffer_pool_(report_ring_buffer_pool_size) {
     //
     // Preparation
     //
 
     virtual_hid_device_service_clients_manager_ = std::make_unique<virtual_hid_device_service_clients_manager>(weak_dispatcher_,
-                                                                                                               run_loop_thread_);
+                                                                                                               driver_backend_);
     virtual_hid_device_service_clients_manager_->status_changed.connect([this](auto peer_id, const auto& response) {
       async_deliver_status(peer_id,
                            response);
@@ -41,6 +58,7 @@ public:
     detach_from_dispatcher([this] {
       create_server_retry_timer_.stop();
       server_ = nullptr;
+      peer_entries_.clear();
 
       virtual_hid_device_service_clients_manager_ = nullptr;
     });
@@ -49,6 +67,60 @@ public:
   }
 
 private:
+  using request = pqrs::karabiner::driverkit::virtual_hid_device_service::request;
+
+  enum class device {
+    none,
+    keyboard,
+    pointing,
+  };
+
+  struct request_handler;
+
+  // Returns the response. (The response is empty for one-way messages and errors.)
+  using request_handler_function = std::vector<uint8_t> (virtual_hid_device_service_server::*)(pqrs::unix_domain_stream::peer_id peer_id,
+                                                                                               const request_handler& handler,
+                                                                                               std::shared_ptr<std::vector<uint8_t>> buffer,
+                                                                                               size_t payload_offset);
+
+  // A row of `request_handlers_`.
+  struct request_handler final {
+    request request_type;
+    std::string_view name;
+    // The payload size following the request, or std::nullopt if the size is variable.
+    std::optional<size_t> payload_size;
+    device target_device;
+    // The method to post reports. (Set only for post report requests.)
+    std::optional<pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method> user_client_method;
+    // The counter of received reports in `statistics`. (Set only for post report requests.)
+    report_statistics::counter received_reports_counter;
+    const char* report_name;
+    bool log_received;
+    // Whether the message is counted in `peer_entry::handled_message_count`.
+    // (The client sends `request::report_ring_doorbell` without counting it.)
+    bool counted_message;
+    request_handler_function function;
+  };
+
+  static constexpr size_t request_count = std::to_underlying(request::get_statistics) + 1;
+
+  // The handlers indexed by `request`. (Defined after the class.)
+  static const std::array<request_handler, request_count> request_handlers_;
+
+  // The limit of the total capacity of `report_ring_buffer_pool_`.
+  static constexpr size_t report_ring_buffer_pool_size = 64 * 1024;
+
+  struct peer_entry final {
+    pqrs::unix_domain_stream::peer_credentials credentials;
+
+    // The number of messages handled in `handle_request` except `request::report_ring_doorbell`.
+    uint64_t handled_message_count = 0;
+
+    std::unique_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::report_ring> report_ring;
+    // Whether `drain_report_ring` is enqueued for reports which do not ring the doorbell.
+    bool report_ring_drain_scheduled = false;
+  };
+
   template <typename T>
   static bool read_data(const std::vector<uint8_t>& buffer,
                         size_t& offset,
@@ -68,9 +140,11 @@ private:
   }
 
   bool create_rootonly_directory() const {
+    auto directory = socket_file_path_.parent_path();
+
     std::error_code error_code;
     std::filesystem::create_directories(
-        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::get_rootonly_directory(),
+        directory,
         error_code);
     if (error_code) {
       logger::get_logger()->error(
@@ -81,7 +155,7 @@ private:
     }
 
     std::filesystem::permissions(
-        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::get_rootonly_directory(),
+        directory,
         std::filesystem::perms::owner_all,
         error_code);
     if (error_code) {
@@ -99,7 +173,9 @@ private:
     create_server_retry_timer_.stop();
 
     // Prepare socket directories.
-    if (!prepare_socket_directories()) {
+    // (The service manager prepares them when the socket is passed.)
+    if (!listening_socket_ &&
+        !prepare_socket_directories()) {
       start_create_server_retry_timer();
       return;
     }
@@ -111,11 +187,16 @@ private:
         {
             .bind_retry_interval = std::chrono::milliseconds(1000),
             .socket_path_health_check_interval = std::chrono::milliseconds(3000),
+            // Post report requests are sent as one-way messages and do not have a response.
+            // They are handled through `received_handler`, which does not allocate memory per message as `received` does.
+            .received_handler = [this](auto peer_id, auto&& buffer) {
+              handle_request(peer_id, buffer);
+            },
         });
 
     server_ = std::make_unique<pqrs::unix_domain_stream::server>(
         weak_dispatcher_,
-        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::get_server_socket_file_path(),
+        socket_file_path_,
         options);
 
     server_->bound.connect([] {
@@ -128,7 +209,8 @@ private:
 
       // If the socket directory is deleted for any reason,
       // bind_failed will be triggered, so recreate the directory each time.
-      if (!prepare_socket_directories()) {
+      if (!listening_socket_ &&
+          !prepare_socket_directories()) {
         if (server_) {
           server_->async_stop();
         }
@@ -145,9 +227,15 @@ private:
       logger::get_logger()->debug("virtual_hid_device_service_server: closed");
     });
 
-    server_->peer_connected.connect([this](auto peer_id, auto&&) {
+    server_->peer_connected.connect([this](auto peer_id, auto&& peer_credentials) {
       logger::get_logger()->debug("virtual_hid_device_service_server: peer_connected ({0})",
                                   peer_id);
+      logger::trace(trace_event::peer_connected,
+                    peer_id,
+                    peer_credentials.pid.value_or(0),
+                    peer_credentials.uid.value_or(0));
+
+      peer_entries_[peer_id].credentials = peer_credentials;
 
       virtual_hid_device_service_clients_manager_->create_client(peer_id);
       virtual_hid_device_service_clients_manager_->async_check_status_changed(peer_id);
@@ -156,200 +244,416 @@ private:
     server_->peer_closed.connect([this](auto peer_id) {
       logger::get_logger()->debug("virtual_hid_device_service_server: peer_closed ({0})",
                                   peer_id);
+      logger::trace(trace_event::peer_closed,
+                    peer_id);
 
       virtual_hid_device_service_clients_manager_->erase_client(peer_id);
+
+      peer_entries_.erase(peer_id);
     });
 
     server_->peer_error_occurred.connect([](auto peer_id, auto&& error_code) {
       logger::get_logger()->debug("virtual_hid_device_service_server: peer_error_occurred ({0}): {1}",
                                   peer_id,
                                   error_code.message());
+      logger::trace(trace_event::peer_error_occurred,
+                    peer_id,
+                    error_code.value());
     });
 
     server_->request_received.connect([this](auto peer_id, auto request_id, auto&& buffer) {
-      auto respond_empty = [this, peer_id, request_id] {
-        if (server_) {
-          server_->async_respond(peer_id, request_id, {});
-        }
-      };
+      auto response = handle_request(peer_id, buffer);
 
-      if (buffer->empty()) {
-        logger::get_logger()->error("virtual_hid_device_service_server: payload is empty");
-        respond_empty();
-        return;
+      if (server_) {
+        server_->async_respond(peer_id,
+                               request_id,
+                               std::move(response));
       }
+    });
 
-      size_t offset = 0;
+    if (listening_socket_) {
+      // `server_` is created only once in this case, since it is recreated only when `prepare_socket_directories` fails.
+      server_->async_start(*listening_socket_);
+    } else {
+      server_->async_start();
+    }
+  }
 
-      //
-      // Read common data
-      //
-      // buffer[0]: client_protocol_version[0]
-      // buffer[1]: client_protocol_version[1]
-      // buffer[2]: pqrs::karabiner::driverkit::virtual_hid_device_service::request
+  // This method is executed in the dispatcher thread.
+  // Returns the response. (The response is empty for one-way messages and errors.)
+  std::vector<uint8_t> handle_request(pqrs::unix_domain_stream::peer_id peer_id,
+                                      std::shared_ptr<std::vector<uint8_t>> buffer) {
+    bool counted_message = true;
 
-      pqrs::karabiner::driverkit::client_protocol_version::value_t received_client_protocol_version(0);
-      if (!read_data(*buffer, offset, received_client_protocol_version)) {
-        logger::get_logger()->error("virtual_hid_device_service_server: payload is not enough");
-        respond_empty();
-        return;
-      }
+    auto it = peer_entries_.find(peer_id);
+    if (it == std::end(peer_entries_)) {
+      return handle_payload(peer_id, buffer, counted_message);
+    }
 
-      pqrs::karabiner::driverkit::virtual_hid_device_service::request request{};
-      if (!read_data(*buffer, offset, request)) {
-        logger::get_logger()->error("virtual_hid_device_service_server: payload is not enough");
-        respond_empty();
-        return;
+    auto& entry = it->second;
+
+    // Reports in the report ring were pushed before this message was sent, so they are handled first.
+    drain_report_ring(peer_id, entry);
+
+    auto response = handle_payload(peer_id, buffer, counted_message);
+
+    if (counted_message) {
+      ++entry.handled_message_count;
+      if (entry.report_ring) {
+        entry.report_ring->set_handled_message_count(entry.handled_message_count);
       }
+    }
 
-      //
-      // Check client protocol version
-      //
+    return response;
+  }
+
+  // This method is executed in the dispatcher thread.
+  // `counted_message` is set to false if the message is not counted by the client. (See `request_handler::counted_message`.)
+  std::vector<uint8_t> handle_payload(pqrs::unix_domain_stream::peer_id peer_id,
+                                      std::shared_ptr<std::vector<uint8_t>> buffer,
+                                      bool& counted_message) {
+    if (buffer->empty()) {
+      logger::get_logger()->error("virtual_hid_device_service_server: payload is empty");
+      return {};
+    }
 
-      if (received_client_protocol_version != pqrs::karabiner::driverkit::client_protocol_version::embedded_client_protocol_version) {
-        logger::get_logger()->warn("client protocol version is mismatched: expected: {0}, actual: {1}",
-                                   type_safe::get(pqrs::karabiner::driverkit::client_protocol_version::embedded_client_protocol_version),
-                                   type_safe::get(received_client_protocol_version));
-        respond_empty();
-        return;
+    size_t offset = 0;
+
+    //
+    // Read common data
+    //
+    // buffer[0]: client_protocol_version[0]
+    // buffer[1]: client_protocol_version[1]
+    // buffer[2]: pqrs::karabiner::driverkit::virtual_hid_device_service::request
+
+    pqrs::karabiner::driverkit::client_protocol_version::value_t received_client_protocol_version(0);
+    if (!read_data(*buffer, offset, received_client_protocol_version)) {
+      logger::get_logger()->error("virtual_hid_device_service_server: payload is not enough");
+      return {};
+    }
+
+    pqrs::karabiner::driverkit::virtual_hid_device_service::request request{};
+    if (!read_data(*buffer, offset, request)) {
+      logger::get_logger()->error("virtual_hid_device_service_server: payload is not enough");
+      return {};
+    }
+
+    //
+    // Check client protocol version
+    //
+
+    if (received_client_protocol_version != pqrs::karabiner::driverkit::client_protocol_version::embedded_client_protocol_version) {
+      logger::get_logger()->warn("client protocol version is mismatched: expected: {0}, actual: {1}",
+                                 type_safe::get(pqrs::karabiner::driverkit::client_protocol_version::embedded_client_protocol_version),
+                                 type_safe::get(received_client_protocol_version));
+      return {};
+    }
+
+    auto index = std::to_underlying(request);
+    if (index < request_handlers_.size()) {
+      counted_message = request_handlers_[index].counted_message;
+    }
+
+    return dispatch_request(peer_id,
+                            request,
+                            buffer,
+                            offset,
+                            buffer->size() - offset);
+  }
+
+  // This method is executed in the dispatcher thread.
+  std::vector<uint8_t> dispatch_request(pqrs::unix_domain_stream::peer_id peer_id,
+                                        request request_type,
+                                        std::shared_ptr<std::vector<uint8_t>> buffer,
+                                        size_t payload_offset,
+                                        size_t payload_size) {
+    auto index = std::to_underlying(request_type);
+    if (index >= request_handlers_.size()) {
+      logger::get_logger()->warn("virtual_hid_device_service_server: unknown request");
+      return {};
+    }
+
+    const auto& handler = request_handlers_[index];
+
+    if (handler.payload_size &&
+        *handler.payload_size != payload_size) {
+      if (auto suppressed_count = request_error_log_limiter_.acquire(index)) {
+        logger::get_logger()->warn("virtual_hid_device_service_server: received: {0} buffer size error{1}",
+                                   handler.name,
+                                   log_limiter::make_suppressed_message(*suppressed_count));
       }
 
-      //
-      // Handle request
-      //
+      if (handler.user_client_method) {
+        virtual_hid_device_service_clients_manager_->record_report_size_error(peer_id,
+                                                                              handler.received_reports_counter);
+      }
 
-      switch (request) {
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_keyboard_initialize: {
-          logger::get_logger()->debug("peer_id:{0} received request::virtual_hid_keyboard_initialize",
-                                      peer_id);
+      return {};
+    }
 
-          auto payload_size = buffer->size() - offset;
-          if (sizeof(pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters) != payload_size) {
-            logger::get_logger()->warn("virtual_hid_device_service_server: received: virtual_hid_keyboard_initialize buffer size error");
-            respond_empty();
-            return;
-          }
+    logger::trace(trace_event::request_received,
+                  peer_id,
+                  request_type);
 
-          pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters parameters;
-          std::memcpy(std::addressof(parameters),
-                      buffer->data() + offset,
-                      sizeof(parameters));
+    if (handler.log_received) {
+      logger::get_logger()->debug("peer_id:{0} received request::{1}",
+                                  peer_id,
+                                  handler.name);
+    }
 
-          virtual_hid_device_service_clients_manager_->initialize_keyboard(peer_id,
-                                                                           parameters);
-          break;
-        }
+    return (this->*handler.function)(peer_id,
+                                     handler,
+                                     std::move(buffer),
+                                     payload_offset);
+  }
 
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_keyboard_terminate:
-          logger::get_logger()->debug("peer_id:{0} received request::virtual_hid_keyboard_terminate",
-                                      peer_id);
+  //
+  // Request handlers
+  //
+
+  std::vector<uint8_t> handle_virtual_hid_keyboard_initialize(pqrs::unix_domain_stream::peer_id peer_id,
+                                                              const request_handler&,
+                                                              std::shared_ptr<std::vector<uint8_t>> buffer,
+                                                              size_t payload_offset) {
+    pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters parameters;
+    std::memcpy(std::addressof(parameters),
+                buffer->data() + payload_offset,
+                sizeof(parameters));
+
+    virtual_hid_device_service_clients_manager_->initialize_keyboard(peer_id,
+                                                                     parameters);
+    return virtual_hid_device_service_clients_manager_->make_response(peer_id);
+  }
 
-          virtual_hid_device_service_clients_manager_->terminate_keyboard(peer_id);
-          break;
+  std::vector<uint8_t> handle_virtual_hid_keyboard_terminate(pqrs::unix_domain_stream::peer_id peer_id,
+                                                             const request_handler&,
+                                                             std::shared_ptr<std::vector<uint8_t>>,
+                                                             size_t) {
+    virtual_hid_device_service_clients_manager_->terminate_keyboard(peer_id);
+    return virtual_hid_device_service_clients_manager_->make_response(peer_id);
+  }
 
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_keyboard_reset:
-          virtual_hid_device_service_clients_manager_->virtual_hid_keyboard_reset(peer_id);
-          break;
+  std::vector<uint8_t> handle_virtual_hid_keyboard_reset(pqrs::unix_domain_stream::peer_id peer_id,
+                                                         const request_handler&,
+                                                         std::shared_ptr<std::vector<uint8_t>>,
+                                                         size_t) {
+    virtual_hid_device_service_clients_manager_->virtual_hid_keyboard_reset(peer_id);
+    return virtual_hid_device_service_clients_manager_->make_response(peer_id);
+  }
 
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_pointing_initialize: {
-          logger::get_logger()->debug("peer_id:{0} received request::virtual_hid_pointing_initialize",
-                                      peer_id);
+  std::vector<uint8_t> handle_virtual_hid_pointing_initialize(pqrs::unix_domain_stream::peer_id peer_id,
+                                                              const request_handler&,
+                                                              std::shared_ptr<std::vector<uint8_t>>,
+                                                              size_t) {
+    virtual_hid_device_service_clients_manager_->initialize_pointing(peer_id);
+    return virtual_hid_device_service_clients_manager_->make_response(peer_id);
+  }
 
-          virtual_hid_device_service_clients_manager_->initialize_pointing(peer_id);
-          break;
-        }
+  std::vector<uint8_t> handle_virtual_hid_pointing_terminate(pqrs::unix_domain_stream::peer_id peer_id,
+                                                             const request_handler&,
+                                                             std::shared_ptr<std::vector<uint8_t>>,
+                                                             size_t) {
+    virtual_hid_device_service_clients_manager_->terminate_pointing(peer_id);
+    return virtual_hid_device_service_clients_manager_->make_response(peer_id);
+  }
 
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_pointing_terminate:
-          logger::get_logger()->debug("peer_id:{0} received request::virtual_hid_pointing_terminate",
-                                      peer_id);
-
-          virtual_hid_device_service_clients_manager_->terminate_pointing(peer_id);
-          break;
-
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_pointing_reset:
-          virtual_hid_device_service_clients_manager_->virtual_hid_pointing_reset(peer_id);
-          break;
-
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_keyboard_input_report:
-          virtual_hid_device_service_clients_manager_->post_keyboard_report(
-              peer_id,
-              buffer,
-              offset,
-              pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-              "virtual_hid_keyboard_post_report(keyboard_input)",
-              sizeof(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input));
-          respond_empty();
-          return;
-
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_consumer_input_report:
-          virtual_hid_device_service_clients_manager_->post_keyboard_report(
-              peer_id,
-              buffer,
-              offset,
-              pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-              "virtual_hid_keyboard_post_report(consumer_input)",
-              sizeof(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::consumer_input));
-          respond_empty();
-          return;
-
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_apple_vendor_keyboard_input_report:
-          virtual_hid_device_service_clients_manager_->post_keyboard_report(
-              peer_id,
-              buffer,
-              offset,
-              pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-              "virtual_hid_keyboard_post_report(apple_vendor_keyboard_input)",
-              sizeof(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input));
-          respond_empty();
-          return;
-
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_apple_vendor_top_case_input_report:
-          virtual_hid_device_service_clients_manager_->post_keyboard_report(
-              peer_id,
-              buffer,
-              offset,
-              pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-              "virtual_hid_keyboard_post_report(apple_vendor_top_case_input)",
-              sizeof(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_top_case_input));
-          respond_empty();
-          return;
-
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_generic_desktop_input_report:
-          virtual_hid_device_service_clients_manager_->post_keyboard_report(
-              peer_id,
-              buffer,
-              offset,
-              pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-              "virtual_hid_keyboard_post_report(generic_desktop_input)",
-              sizeof(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::generic_desktop_input));
-          respond_empty();
-          return;
-
-        case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_pointing_input_report:
-          virtual_hid_device_service_clients_manager_->post_pointing_report(
-              peer_id,
-              buffer,
-              offset,
-              pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_post_report,
-              "virtual_hid_pointing_post_report(pointing_input)",
-              sizeof(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input));
-          respond_empty();
-          return;
-
-        default:
-          logger::get_logger()->warn("virtual_hid_device_service_server: unknown request");
-          respond_empty();
-          return;
+  std::vector<uint8_t> handle_virtual_hid_pointing_reset(pqrs::unix_domain_stream::peer_id peer_id,
+                                                         const request_handler&,
+                                                         std::shared_ptr<std::vector<uint8_t>>,
+                                                         size_t) {
+    virtual_hid_device_service_clients_manager_->virtual_hid_pointing_reset(peer_id);
+    return virtual_hid_device_service_clients_manager_->make_response(peer_id);
+  }
+
+  std::vector<uint8_t> handle_post_report(pqrs::unix_domain_stream::peer_id peer_id,
+                                          const request_handler& handler,
+                                          std::shared_ptr<std::vector<uint8_t>> buffer,
+                                          size_t payload_offset) {
+    switch (handler.target_device) {
+      case device::keyboard:
+        virtual_hid_device_service_clients_manager_->post_keyboard_report(
+            peer_id,
+            handler.request_type,
+            handler.received_reports_counter,
+            std::move(buffer),
+            payload_offset,
+            *handler.payload_size,
+            *handler.user_client_method,
+            handler.report_name);
+        break;
+
+      case device::pointing:
+        virtual_hid_device_service_clients_manager_->post_pointing_report(
+            peer_id,
+            handler.request_type,
+            handler.received_reports_counter,
+            std::move(buffer),
+            payload_offset,
+            *handler.payload_size,
+            *handler.user_client_method,
+            handler.report_name);
+        break;
+
+      case device::none:
+        break;
+    }
+
+    return {};
+  }
+
+  std::vector<uint8_t> handle_post_report_batch(pqrs::unix_domain_stream::peer_id peer_id,
+                                                const request_handler&,
+                                                std::shared_ptr<std::vector<uint8_t>> buffer,
+                                                size_t payload_offset) {
+    // Entries are forwarded in order.
+    //
+    // entry[0]: pqrs::karabiner::driverkit::virtual_hid_device_service::request
+    // entry[1...]: report
+
+    auto offset = payload_offset;
+
+    while (offset < buffer->size()) {
+      request request_type{};
+      if (!read_data(*buffer, offset, request_type)) {
+        break;
       }
 
-      if (server_) {
-        server_->async_respond(peer_id,
-                               request_id,
-                               virtual_hid_device_service_clients_manager_->make_response(peer_id));
+      auto report_size = find_post_report_size(request_type);
+      if (!report_size ||
+          *report_size > buffer->size() - offset) {
+        if (auto suppressed_count = request_error_log_limiter_.acquire()) {
+          logger::get_logger()->warn("virtual_hid_device_service_server: received: post_report_batch buffer error{0}",
+                                     log_limiter::make_suppressed_message(*suppressed_count));
+        }
+        break;
+      }
+
+      dispatch_request(peer_id,
+                       request_type,
+                       buffer,
+                       offset,
+                       *report_size);
+
+      offset += *report_size;
+    }
+
+    return {};
+  }
+
+  std::vector<uint8_t> handle_report_ring_open(pqrs::unix_domain_stream::peer_id peer_id,
+                                               const request_handler&,
+                                               std::shared_ptr<std::vector<uint8_t>> buffer,
+                                               size_t payload_offset) {
+    pqrs::karabiner::driverkit::virtual_hid_device_service::report_ring::name_t name{};
+    std::memcpy(name.data(),
+                buffer->data() + payload_offset,
+                sizeof(name));
+
+    auto opened = open_report_ring(peer_id, name);
+
+    auto response = virtual_hid_device_service_clients_manager_->make_response(peer_id);
+    response.push_back(std::to_underlying(pqrs::karabiner::driverkit::virtual_hid_device_service::response::report_ring_opened));
+    response.push_back(opened);
+    return response;
+  }
+
+  std::vector<uint8_t> handle_report_ring_doorbell(pqrs::unix_domain_stream::peer_id,
+                                                   const request_handler&,
+                                                   std::shared_ptr<std::vector<uint8_t>>,
+                                                   size_t) {
+    // The doorbell only wakes up the server. The report ring is drained in `handle_request`.
+    return {};
+  }
+
+  std::vector<uint8_t> handle_get_statistics(pqrs::unix_domain_stream::peer_id peer_id,
+                                             const request_handler&,
+                                             std::shared_ptr<std::vector<uint8_t>>,
+                                             size_t) {
+    return virtual_hid_device_service_clients_manager_->make_statistics_response(peer_id);
+  }
+
+  // Returns the report size of post report requests, or std::nullopt for other requests.
+  static std::optional<size_t> find_post_report_size(request request_type) {
+    auto index = std::to_underlying(request_type);
+    if (index >= request_handlers_.size() ||
+        !request_handlers_[index].user_client_method) {
+      return std::nullopt;
+    }
+
+    return request_handlers_[index].payload_size;
+  }
+
+  // This method is executed in the dispatcher thread.
+  bool open_report_ring(pqrs::unix_domain_stream::peer_id peer_id,
+                        const pqrs::karabiner::driverkit::virtual_hid_device_service::report_ring::name_t& name) {
+    auto it = peer_entries_.find(peer_id);
+    if (it == std::end(peer_entries_) ||
+        !it->second.credentials.uid) {
+      logger::get_logger()->warn("virtual_hid_device_service_server: report_ring_open peer credentials are not found");
+      return false;
+    }
+
+    // The shared memory must be owned by the peer.
+    it->second.report_ring = pqrs::karabiner::driverkit::virtual_hid_device_service::report_ring::open(name,
+                                                                                                      *(it->second.credentials.uid));
+    if (!it->second.report_ring) {
+      logger::get_logger()->warn("virtual_hid_device_service_server: report_ring::open error");
+      return false;
+    }
+
+    return true;
+  }
+
+  // This method is executed in the dispatcher thread.
+  void drain_report_ring(pqrs::unix_domain_stream::peer_id peer_id,
+                         peer_entry& entry) {
+    if (!entry.report_ring) {
+      return;
+    }
+
+    using drain_result = pqrs::karabiner::driverkit::virtual_hid_device_service::report_ring::drain_result;
+
+    auto result = entry.report_ring->drain([this, peer_id](auto request_type, auto&& report) {
+      if (find_post_report_size(request_type)) {
+        virtual_hid_device_service_clients_manager_->record_report_ring_report(peer_id);
+
+        // The buffer is reused after the report strand has passed the report to the driver.
+        auto buffer = report_ring_buffer_pool_.acquire(report.size());
+        std::ranges::copy(report, std::begin(*buffer));
+
+        dispatch_request(peer_id,
+                         request_type,
+                         buffer,
+                         0,
+                         report.size());
       }
     });
 
-    server_->async_start();
+    switch (result) {
+      case drain_result::broken:
+        logger::get_logger()->warn("virtual_hid_device_service_server: report_ring is broken ({0})",
+                                   peer_id);
+        entry.report_ring = nullptr;
+        break;
+
+      case drain_result::drained:
+        break;
+
+      case drain_result::pending:
+        // Drain the rest later so that other peers and timers are not delayed by a client which keeps pushing.
+        if (!entry.report_ring_drain_scheduled) {
+          entry.report_ring_drain_scheduled = true;
+
+          enqueue_to_dispatcher([this, peer_id] {
+            auto it = peer_entries_.find(peer_id);
+            if (it != std::end(peer_entries_)) {
+              it->second.report_ring_drain_scheduled = false;
+              drain_report_ring(peer_id, it->second);
+            }
+          });
+        }
+        break;
+    }
   }
 
   bool prepare_socket_directories() const {
@@ -380,13 +684,245 @@ private:
             logger::get_logger()->debug("virtual_hid_device_service_server: status delivery failed ({0}): {1}",
                                         peer_id,
                                         error_code.message());
+            logger::trace(trace_event::status_delivery_failed,
+                          peer_id,
+                          error_code.value());
           }
         });
   }
 
-  pqrs::not_null_shared_ptr_t<pqrs::cf::run_loop_thread> run_loop_thread_;
+  pqrs::not_null_shared_ptr_t<driver_backend> driver_backend_;
+  std::filesystem::path socket_file_path_;
+  // The socket is owned by `server_` after it is passed to `server_`.
+  std::optional<int> listening_socket_;
 
   pqrs::dispatcher::extra::timer create_server_retry_timer_;
   std::unique_ptr<virtual_hid_device_service_clients_manager> virtual_hid_device_service_clients_manager_;
   std::unique_ptr<pqrs::unix_domain_stream::server> server_;
+  std::unordered_map<pqrs::unix_domain_stream::peer_id, peer_entry> peer_entries_;
+  // Reports drained from report rings are copied into these buffers. (Used in the dispatcher thread.)
+  pqrs::unix_domain_stream::impl::receive_buffer_pool report_ring_buffer_pool_;
+  // Malformed requests may be repeated for each report by a broken client.
+  log_limiter request_error_log_limiter_;
 };
+
+// Adding a request type means adding one row here.
+// (A new report type also adds its received reports counter to `statistics`.)
+inline constexpr std::array<virtual_hid_device_service_server::request_handler,
+                            virtual_hid_device_service_server::request_count>
+    virtual_hid_device_service_server::request_handlers_ = [] {
+      using request = pqrs::karabiner::driverkit::virtual_hid_device_service::request;
+      using user_client_method = pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method;
+      using self = virtual_hid_device_service_server;
+      using statistics = pqrs::karabiner::driverkit::virtual_hid_device_service::statistics;
+      namespace hid_report = pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+
+      std::array<request_handler, request_count> handlers{{
+          {
+              .request_type = request::virtual_hid_keyboard_initialize,
+              .name = "virtual_hid_keyboard_initialize",
+              .payload_size = sizeof(pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters),
+              .target_device = device::keyboard,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = true,
+              .counted_message = true,
+              .function = &self::handle_virtual_hid_keyboard_initialize,
+          },
+          {
+              .request_type = request::virtual_hid_keyboard_terminate,
+              .name = "virtual_hid_keyboard_terminate",
+              .payload_size = 0,
+              .target_device = device::keyboard,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = true,
+              .counted_message = true,
+              .function = &self::handle_virtual_hid_keyboard_terminate,
+          },
+          {
+              .request_type = request::virtual_hid_keyboard_reset,
+              .name = "virtual_hid_keyboard_reset",
+              .payload_size = 0,
+              .target_device = device::keyboard,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_virtual_hid_keyboard_reset,
+          },
+          {
+              .request_type = request::virtual_hid_pointing_initialize,
+              .name = "virtual_hid_pointing_initialize",
+              .payload_size = 0,
+              .target_device = device::pointing,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = true,
+              .counted_message = true,
+              .function = &self::handle_virtual_hid_pointing_initialize,
+          },
+          {
+              .request_type = request::virtual_hid_pointing_terminate,
+              .name = "virtual_hid_pointing_terminate",
+              .payload_size = 0,
+              .target_device = device::pointing,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = true,
+              .counted_message = true,
+              .function = &self::handle_virtual_hid_pointing_terminate,
+          },
+          {
+              .request_type = request::virtual_hid_pointing_reset,
+              .name = "virtual_hid_pointing_reset",
+              .payload_size = 0,
+              .target_device = device::pointing,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_virtual_hid_pointing_reset,
+          },
+          {
+              .request_type = request::post_keyboard_input_report,
+              .name = "post_keyboard_input_report",
+              .payload_size = sizeof(hid_report::keyboard_input),
+              .target_device = device::keyboard,
+              .user_client_method = user_client_method::virtual_hid_keyboard_post_report,
+              .received_reports_counter = &statistics::received_keyboard_input_reports,
+              .report_name = "virtual_hid_keyboard_post_report(keyboard_input)",
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_post_report,
+          },
+          {
+              .request_type = request::post_consumer_input_report,
+              .name = "post_consumer_input_report",
+              .payload_size = sizeof(hid_report::consumer_input),
+              .target_device = device::keyboard,
+              .user_client_method = user_client_method::virtual_hid_keyboard_post_report,
+              .received_reports_counter = &statistics::received_consumer_input_reports,
+              .report_name = "virtual_hid_keyboard_post_report(consumer_input)",
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_post_report,
+          },
+          {
+              .request_type = request::post_apple_vendor_keyboard_input_report,
+              .name = "post_apple_vendor_keyboard_input_report",
+              .payload_size = sizeof(hid_report::apple_vendor_keyboard_input),
+              .target_device = device::keyboard,
+              .user_client_method = user_client_method::virtual_hid_keyboard_post_report,
+              .received_reports_counter = &statistics::received_apple_vendor_keyboard_input_reports,
+              .report_name = "virtual_hid_keyboard_post_report(apple_vendor_keyboard_input)",
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_post_report,
+          },
+          {
+              .request_type = request::post_apple_vendor_top_case_input_report,
+              .name = "post_apple_vendor_top_case_input_report",
+              .payload_size = sizeof(hid_report::apple_vendor_top_case_input),
+              .target_device = device::keyboard,
+              .user_client_method = user_client_method::virtual_hid_keyboard_post_report,
+              .received_reports_counter = &statistics::received_apple_vendor_top_case_input_reports,
+              .report_name = "virtual_hid_keyboard_post_report(apple_vendor_top_case_input)",
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_post_report,
+          },
+          {
+              .request_type = request::post_generic_desktop_input_report,
+              .name = "post_generic_desktop_input_report",
+              .payload_size = sizeof(hid_report::generic_desktop_input),
+              .target_device = device::keyboard,
+              .user_client_method = user_client_method::virtual_hid_keyboard_post_report,
+              .received_reports_counter = &statistics::received_generic_desktop_input_reports,
+              .report_name = "virtual_hid_keyboard_post_report(generic_desktop_input)",
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_post_report,
+          },
+          {
+              .request_type = request::post_pointing_input_report,
+              .name = "post_pointing_input_report",
+              .payload_size = sizeof(hid_report::pointing_input),
+              .target_device = device::pointing,
+              .user_client_method = user_client_method::virtual_hid_pointing_post_report,
+              .received_reports_counter = &statistics::received_pointing_input_reports,
+              .report_name = "virtual_hid_pointing_post_report(pointing_input)",
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_post_report,
+          },
+          {
+              .request_type = request::post_report_batch,
+              .name = "post_report_batch",
+              .payload_size = std::nullopt,
+              .target_device = device::none,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_post_report_batch,
+          },
+          {
+              .request_type = request::report_ring_open,
+              .name = "report_ring_open",
+              .payload_size = sizeof(pqrs::karabiner::driverkit::virtual_hid_device_service::report_ring::name_t),
+              .target_device = device::none,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = true,
+              .counted_message = true,
+              .function = &self::handle_report_ring_open,
+          },
+          {
+              .request_type = request::report_ring_doorbell,
+              .name = "report_ring_doorbell",
+              .payload_size = 0,
+              .target_device = device::none,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = false,
+              .counted_message = false,
+              .function = &self::handle_report_ring_doorbell,
+          },
+          {
+              .request_type = request::get_statistics,
+              .name = "get_statistics",
+              .payload_size = 0,
+              .target_device = device::none,
+              .user_client_method = std::nullopt,
+              .received_reports_counter = nullptr,
+              .report_name = nullptr,
+              .log_received = false,
+              .counted_message = true,
+              .function = &self::handle_get_statistics,
+          },
+      }};
+
+      // The table is indexed by `request`. (A misordered row fails to compile.)
+      for (size_t i = 0; i < handlers.size(); ++i) {
+        if (std::to_underlying(handlers[i].request_type) != i ||
+            handlers[i].function == nullptr) {
+          throw "request_handlers_ is not ordered by request";
+        }
+
+        if (handlers[i].user_client_method.has_value() != (handlers[i].received_reports_counter != nullptr)) {
+          throw "post report rows require received_reports_counter";
+        }
+      }
+
+      return handlers;
+    }();
@@ -1,7 +1,9 @@
-#include "io_service_client.hpp"
+#include "iokit_driver_backend.hpp"
+#include "socket_activation.hpp"
 #include "version.hpp"
 #include "virtual_hid_device_service_server.hpp"
 #include <chrono>
+#include <filesystem>
 #include <iostream>
 #include <memory>
 #include <pqrs/hid.hpp>
@@ -31,11 +33,33 @@ int main() {
   logger::get_logger()->info("driver_version {0}", DRIVER_VERSION);
   logger::get_logger()->info("client_protocol_version {0}", CLIENT_PROTOCOL_VERSION);
 
+  // The trace records requests and reports in a compact binary form for diagnosing issues afterwards.
+  // It is enabled when this file exists at startup. (e.g., `sudo touch /var/log/karabiner/virtual_hid_device_service_trace`)
+  // `tools/trace-decoder` renders it.
+  {
+    const char* trace_file_path = "/var/log/karabiner/virtual_hid_device_service_trace";
+    std::error_code error_code;
+    if (std::filesystem::exists(trace_file_path, error_code)) {
+      if (logger::set_trace_log(trace_file_path, 16 * 1024 * 1024)) {
+        logger::get_logger()->info("trace is enabled: {0}", trace_file_path);
+      } else {
+        logger::get_logger()->error("failed to create trace: {0}", trace_file_path);
+      }
+    }
+  }
+
   //
   // Create instances
   //
 
-  auto server = std::make_unique<virtual_hid_device_service_server>(pqrs::cf::run_loop_thread::extra::get_shared_run_loop_thread());
+  auto listening_socket = socket_activation::get_listening_socket();
+  if (listening_socket) {
+    logger::get_logger()->info("socket activation is enabled");
+  }
+
+  auto server = std::make_unique<virtual_hid_device_service_server>(std::make_shared<iokit_driver_backend>(pqrs::cf::run_loop_thread::extra::get_shared_run_loop_thread()),
+                                                                    pqrs::karabiner::driverkit::virtual_hid_device_service::constants::get_server_socket_file_path(),
+                                                                    listening_socket);
 
   //
   // Set signal handler
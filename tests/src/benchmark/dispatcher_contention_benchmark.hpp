@@ -0,0 +1,104 @@
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <pqrs/dispatcher.hpp>
+#include <thread>
+#include <vector>
+
+namespace dispatcher_contention_benchmark {
+constexpr size_t producer_count = 8;
+constexpr size_t function_count_per_producer = 100000;
+
+class client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  explicit client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher)
+      : dispatcher_client(weak_dispatcher) {
+  }
+
+  ~client() override {
+    detach_from_dispatcher();
+  }
+};
+
+struct result final {
+  // Nanoseconds per `enqueue_to_dispatcher` call in a producer thread.
+  double enqueue;
+  // Executed functions per second.
+  double throughput;
+};
+
+// `producer_count` threads enqueue immediate functions at the same time.
+inline result measure() {
+  auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+  auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+  std::atomic<size_t> executed_count = 0;
+  std::atomic<int64_t> enqueue_elapsed = 0;
+  std::chrono::nanoseconds elapsed(0);
+
+  {
+    client c(dispatcher);
+
+    std::atomic<bool> started = false;
+    std::vector<std::thread> producers;
+
+    for (size_t i = 0; i < producer_count; ++i) {
+      producers.emplace_back([&] {
+        while (!started) {
+          std::this_thread::yield();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t j = 0; j < function_count_per_producer; ++j) {
+          c.enqueue_to_dispatcher([&executed_count] {
+            ++executed_count;
+          });
+        }
+
+        enqueue_elapsed += (std::chrono::steady_clock::now() - start).count();
+      });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    started = true;
+
+    for (auto&& p : producers) {
+      p.join();
+    }
+
+    while (executed_count < producer_count * function_count_per_producer) {
+      std::this_thread::yield();
+    }
+
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+
+  dispatcher->terminate();
+
+  auto total_count = producer_count * function_count_per_producer;
+
+  return result{
+      .enqueue = static_cast<double>(enqueue_elapsed) / total_count,
+      .throughput = total_count / std::chrono::duration<double>(elapsed).count(),
+  };
+}
+} // namespace dispatcher_contention_benchmark
+
+void run_dispatcher_contention_benchmark() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "dispatcher_contention"_test = [] {
+    auto r = dispatcher_contention_benchmark::measure();
+
+    std::cout << "dispatcher with " << dispatcher_contention_benchmark::producer_count << " producer threads: "
+              << "enqueue " << r.enqueue << " ns/function, "
+              << r.throughput << " functions/sec" << std::endl;
+
+    expect(r.enqueue > 0.0);
+    expect(r.throughput > 0.0);
+  };
+}
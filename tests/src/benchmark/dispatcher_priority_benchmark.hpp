@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <pqrs/dispatcher.hpp>
+#include <thread>
+#include <vector>
+
+namespace dispatcher_priority_benchmark {
+constexpr int chain_count = 4;
+constexpr int sample_count = 200;
+constexpr auto housekeeping_duration = std::chrono::microseconds(100);
+
+class client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  explicit client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher)
+      : dispatcher_client(weak_dispatcher) {
+  }
+
+  ~client() override {
+    detach_from_dispatcher();
+  }
+
+  void wait(pqrs::dispatcher::priority priority) {
+    std::promise<void> promise;
+    enqueue_to_dispatcher(
+        [&promise] {
+          promise.set_value();
+        },
+        priority);
+    promise.get_future().wait();
+  }
+};
+
+struct result final {
+  // Microseconds from enqueueing a high priority function to its execution.
+  double p50;
+  double p99;
+  int housekeeping_count;
+};
+
+// The low priority queue is kept busy with housekeeping functions which take `housekeeping_duration` each,
+// and a high priority function is enqueued every millisecond.
+inline result measure() {
+  using pqrs::dispatcher::priority;
+
+  auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+  auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+  std::vector<std::chrono::nanoseconds> latencies(sample_count);
+  std::atomic<int> housekeeping_count = 0;
+
+  {
+    client c(dispatcher);
+
+    std::atomic<bool> stopped = false;
+    std::function<void()> housekeeping = [&] {
+      auto end = std::chrono::steady_clock::now() + housekeeping_duration;
+      while (std::chrono::steady_clock::now() < end) {
+      }
+      ++housekeeping_count;
+
+      if (!stopped) {
+        c.enqueue_to_dispatcher(housekeeping, priority::low);
+      }
+    };
+    for (int i = 0; i < chain_count; ++i) {
+      c.enqueue_to_dispatcher(housekeeping, priority::low);
+    }
+
+    for (int i = 0; i < sample_count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+      c.enqueue_to_dispatcher(
+          [&latencies, i, enqueued_time = std::chrono::steady_clock::now()] {
+            latencies[i] = std::chrono::steady_clock::now() - enqueued_time;
+          },
+          priority::high);
+    }
+
+    c.wait(priority::high);
+    stopped = true;
+    c.wait(priority::low);
+  }
+
+  dispatcher->terminate();
+
+  std::ranges::sort(latencies);
+
+  return result{
+      .p50 = latencies[sample_count * 50 / 100].count() / 1000.0,
+      .p99 = latencies[sample_count * 99 / 100].count() / 1000.0,
+      .housekeeping_count = housekeeping_count,
+  };
+}
+} // namespace dispatcher_priority_benchmark
+
+void run_dispatcher_priority_benchmark() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "dispatcher_priority"_test = [] {
+    auto r = dispatcher_priority_benchmark::measure();
+
+    std::cout << "high priority latency with busy low priority queue: "
+              << "p50 " << r.p50 << " us, "
+              << "p99 " << r.p99 << " us "
+              << "(" << r.housekeeping_count << " housekeeping functions)" << std::endl;
+
+    expect(r.housekeeping_count > 0_i);
+  };
+}
@@ -0,0 +1,99 @@
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <pqrs/dispatcher.hpp>
+#include <random>
+#include <thread>
+
+namespace dispatcher_timer_benchmark {
+constexpr size_t pending_timer_count = 10000;
+constexpr size_t iteration_count = 10;
+constexpr auto max_delay = std::chrono::milliseconds(10000);
+
+class client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  explicit client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher)
+      : dispatcher_client(weak_dispatcher) {
+  }
+
+  ~client() override {
+    detach_from_dispatcher();
+  }
+};
+
+struct result final {
+  // Nanoseconds per entry.
+  double enqueue;
+  double execute;
+};
+
+// Each iteration enqueues `pending_timer_count` delayed functions in random order,
+// then advances the pseudo time so that all of them are executed.
+inline result measure() {
+  auto time_source = std::make_shared<pqrs::dispatcher::pseudo_time_source>();
+  auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> distribution(1, max_delay.count());
+
+  std::atomic<size_t> executed_count = 0;
+  std::chrono::nanoseconds enqueue_elapsed(0);
+  std::chrono::nanoseconds execute_elapsed(0);
+
+  {
+    client c(dispatcher);
+
+    for (size_t i = 0; i < iteration_count; ++i) {
+      auto now = time_source->now();
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t j = 0; j < pending_timer_count; ++j) {
+        c.enqueue_to_dispatcher(
+            [&executed_count] {
+              ++executed_count;
+            },
+            now + pqrs::dispatcher::duration(distribution(engine)));
+      }
+
+      enqueue_elapsed += std::chrono::steady_clock::now() - start;
+
+      start = std::chrono::steady_clock::now();
+
+      time_source->set_now(now + max_delay);
+      dispatcher->invoke();
+
+      while (executed_count < pending_timer_count * (i + 1)) {
+        std::this_thread::yield();
+      }
+
+      execute_elapsed += std::chrono::steady_clock::now() - start;
+    }
+  }
+
+  dispatcher->terminate();
+
+  return result{
+      .enqueue = static_cast<double>(enqueue_elapsed.count()) / (pending_timer_count * iteration_count),
+      .execute = static_cast<double>(execute_elapsed.count()) / (pending_timer_count * iteration_count),
+  };
+}
+} // namespace dispatcher_timer_benchmark
+
+void run_dispatcher_timer_benchmark() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "dispatcher_timer"_test = [] {
+    auto r = dispatcher_timer_benchmark::measure();
+
+    std::cout << "dispatcher with " << dispatcher_timer_benchmark::pending_timer_count << " pending timers: "
+              << "enqueue " << r.enqueue << " ns/entry, "
+              << "execute " << r.execute << " ns/entry" << std::endl;
+
+    expect(r.enqueue > 0.0);
+    expect(r.execute > 0.0);
+  };
+}
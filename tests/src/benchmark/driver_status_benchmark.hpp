@@ -0,0 +1,178 @@
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <driver_connection_handle.hpp>
+#include <driver_status.hpp>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace driver_status_benchmark {
+constexpr size_t post_count = 10000000;
+constexpr size_t thread_count = 4;
+
+// The previous implementation of the status checks in `io_service_client::post_report`,
+// which locks `driver_version_mutex_` in both `driver_connected` and `driver_version_mismatched`.
+class mutex_status final {
+public:
+  bool driver_connected() const {
+    std::lock_guard<std::mutex> lock(driver_version_mutex_);
+
+    return driver_version_ != std::nullopt;
+  }
+
+  bool driver_version_mismatched() const {
+    std::lock_guard<std::mutex> lock(driver_version_mutex_);
+
+    if (driver_version_ == std::nullopt) {
+      return false;
+    }
+
+    return driver_version_ != pqrs::karabiner::driverkit::driver_version::embedded_driver_version;
+  }
+
+  void set_driver_version(std::optional<pqrs::karabiner::driverkit::driver_version::value_t> value) {
+    std::lock_guard<std::mutex> lock(driver_version_mutex_);
+
+    driver_version_ = value;
+  }
+
+private:
+  mutable std::mutex driver_version_mutex_;
+  std::optional<pqrs::karabiner::driverkit::driver_version::value_t> driver_version_;
+};
+
+inline thread_local volatile unsigned int last_connection;
+
+// A stand-in for `IOConnectCallStructMethod`.
+[[gnu::noinline]] inline int driver_call(unsigned int connection) {
+  last_connection = connection;
+  return 0;
+}
+
+// The previous connection of `io_service_client`, which is locked by `connection_mutex_` during a driver call.
+class mutex_connection final {
+public:
+  explicit mutex_connection(unsigned int connection)
+      : connection_(connection) {
+  }
+
+  template <typename F>
+  int call(F&& function) const {
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+
+    if (!connection_) {
+      return -1;
+    }
+
+    return function(connection_);
+  }
+
+private:
+  mutable std::mutex connection_mutex_;
+  unsigned int connection_;
+};
+
+// The `io_service_client::post_report` sequence: get the connection, check whether the driver is usable, and call the driver.
+// Each thread posts through its own connection as the report strands of different peers do, while the status is shared.
+// Returns the nanoseconds per post.
+template <typename MakeConnection, typename Post>
+double measure(size_t threads, MakeConnection make_connection, Post post) {
+  std::atomic<uint64_t> posted_count = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i] {
+      auto connection = make_connection(static_cast<unsigned int>(i + 1));
+      uint64_t count = 0;
+
+      for (size_t j = 0; j < post_count / threads; ++j) {
+        if (post(*connection) == 0) {
+          ++count;
+        }
+      }
+
+      posted_count += count;
+    });
+  }
+  for (auto&& w : workers) {
+    w.join();
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  if (posted_count != (post_count / threads) * threads) {
+    return 0.0;
+  }
+
+  return static_cast<double>(elapsed.count()) * static_cast<double>(threads) / static_cast<double>(post_count);
+}
+} // namespace driver_status_benchmark
+
+void run_driver_status_benchmark() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "driver_status post_report"_test = [] {
+    using namespace driver_status_benchmark;
+
+    mutex_status m;
+    m.set_driver_version(pqrs::karabiner::driverkit::driver_version::embedded_driver_version);
+
+    driver_status s;
+    s.set_driver_version(pqrs::karabiner::driverkit::driver_version::embedded_driver_version);
+
+    auto make_mutex_connection = [](unsigned int connection) {
+      return std::make_unique<mutex_connection>(connection);
+    };
+    auto make_connection_handle = [](unsigned int connection) {
+      auto handle = std::make_unique<driver_connection_handle<unsigned int>>();
+      handle->publish(connection);
+      return handle;
+    };
+
+    for (auto threads : {size_t(1), thread_count}) {
+      auto mutex_result = measure(threads, make_mutex_connection, [&m](auto&& connection) {
+        return connection.call([&m](auto c) {
+          if (!m.driver_connected() ||
+              m.driver_version_mismatched()) {
+            return -1;
+          }
+          return driver_call(c);
+        });
+      });
+      auto mutex_atomic_result = measure(threads, make_mutex_connection, [&s](auto&& connection) {
+        return connection.call([&s](auto c) {
+          if (!s.driver_usable()) {
+            return -1;
+          }
+          return driver_call(c);
+        });
+      });
+      auto atomic_result = measure(threads, make_connection_handle, [&s](auto&& connection) {
+        return connection.call(
+            [&s](auto c) {
+              if (!s.driver_usable()) {
+                return -1;
+              }
+              return driver_call(c);
+            },
+            -1);
+      });
+
+      expect(mutex_result > 0.0);
+      expect(mutex_atomic_result > 0.0);
+      expect(atomic_result > 0.0);
+
+      std::cout << "post_report with " << threads << " threads: "
+                << "connection mutex and status mutex " << mutex_result << " ns/post, "
+                << "connection mutex and atomic word " << mutex_atomic_result << " ns/post, "
+                << "connection handle and atomic word " << atomic_result << " ns/post" << std::endl;
+    }
+  };
+}
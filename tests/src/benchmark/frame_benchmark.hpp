@@ -0,0 +1,91 @@
+#include <boost/ut.hpp>
+#include <chrono>
+#include <iostream>
+#include <pqrs/unix_domain_stream/impl/protocol.hpp>
+
+namespace frame_benchmark {
+constexpr size_t frame_count = 1000000;
+
+// The payload size of `request::post_keyboard_input_report`.
+constexpr size_t payload_size = 70;
+
+// The previous encoding which copies the header and the payload into one vector.
+inline std::vector<uint8_t> make_contiguous_request_frame(uint64_t request_id,
+                                                          const std::vector<uint8_t>& data) {
+  using namespace pqrs::unix_domain_stream::impl::protocol;
+
+  auto body_size = type_size + request_id_size + data.size();
+
+  std::array<uint8_t, header_size> header;
+  encode_uint32(header, static_cast<uint32_t>(body_size));
+
+  std::array<uint8_t, request_id_size> encoded_request_id;
+  encode_uint64(encoded_request_id, request_id);
+
+  std::vector<uint8_t> frame;
+  frame.reserve(header_size + body_size);
+  frame.insert(frame.end(), header.begin(), header.end());
+  frame.push_back(std::to_underlying(message_type::request));
+  frame.insert(frame.end(), encoded_request_id.begin(), encoded_request_id.end());
+  frame.insert(frame.end(), data.begin(), data.end());
+
+  return frame;
+}
+
+// Returns nanoseconds per frame.
+template <typename F>
+double measure(F&& f) {
+  size_t total_size = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < frame_count; ++i) {
+    std::vector<uint8_t> payload(payload_size, static_cast<uint8_t>(i));
+    total_size += f(i, std::move(payload));
+  }
+
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+  // Use the result in order to prevent the loop from being optimized away.
+  if (total_size == 0) {
+    std::cout << "unexpected total_size" << std::endl;
+  }
+
+  return elapsed.count() / frame_count;
+}
+} // namespace frame_benchmark
+
+void run_frame_benchmark() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "frame"_test = [] {
+    using namespace pqrs::unix_domain_stream::impl::protocol;
+
+    auto contiguous = frame_benchmark::measure([](auto i, auto&& payload) {
+      return frame_benchmark::make_contiguous_request_frame(i, payload).size();
+    });
+
+    auto scatter_gather = frame_benchmark::measure([](auto i, auto&& payload) {
+      return make_request_frame(i, std::move(payload)).size();
+    });
+
+    std::cout << "frame construction (contiguous copy): " << contiguous << " ns/frame" << std::endl;
+    std::cout << "frame construction (scatter-gather): " << scatter_gather << " ns/frame" << std::endl;
+
+    // The frame header is encoded in front of the payload.
+
+    std::vector<uint8_t> payload{1, 2, 3};
+    auto f = make_request_frame(0x0102030405060708, payload);
+    auto expected = frame_benchmark::make_contiguous_request_frame(0x0102030405060708, payload);
+
+    std::vector<uint8_t> actual;
+    for (const auto& b : f.buffers()) {
+      auto p = static_cast<const uint8_t*>(b.data());
+      actual.insert(std::end(actual), p, p + b.size());
+    }
+
+    expect(actual == expected);
+    expect(f.size() == expected.size());
+  };
+}
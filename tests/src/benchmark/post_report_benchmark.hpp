@@ -0,0 +1,137 @@
+#include <boost/ut.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <pqrs/unix_domain_stream.hpp>
+
+namespace post_report_benchmark {
+constexpr size_t report_count = 10000;
+
+// The number of reports sent before waiting for them to be processed.
+// This keeps the per-peer write queue below `max_send_queue_size`.
+constexpr size_t window_size = 256;
+
+enum class mode {
+  request,
+  send,
+};
+
+class counter final {
+public:
+  void increment() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++count_;
+    }
+    cv_.notify_all();
+  }
+
+  bool wait(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(10), [this, count] {
+      return count_ >= count;
+    });
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t count_ = 0;
+};
+
+// Returns the number of reports per second.
+inline double measure(mode m) {
+  using namespace pqrs::karabiner::driverkit;
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+  auto socket_file_path = std::filesystem::temp_directory_path() / "virtual_hid_device_service_post_report_benchmark.sock";
+
+  auto buffer = make_request_buffer(request::post_pointing_input_report,
+                                    virtual_hid_device_driver::hid_report::pointing_input());
+  std::vector<uint8_t> payload(std::begin(buffer), std::end(buffer));
+
+  counter connected;
+  counter received;
+  counter responded;
+
+  auto server = std::make_unique<pqrs::unix_domain_stream::server>(pqrs::dispatcher::extra::get_shared_dispatcher(),
+                                                                    socket_file_path);
+  auto client = std::make_unique<pqrs::unix_domain_stream::client>(pqrs::dispatcher::extra::get_shared_dispatcher(),
+                                                                    socket_file_path);
+
+  server->received.connect([&](auto&&, auto&&) {
+    received.increment();
+  });
+  server->request_received.connect([&](auto peer_id, auto request_id, auto&&) {
+    received.increment();
+    server->async_respond(peer_id, request_id, {});
+  });
+  server->bound.connect([&] {
+    client->async_start();
+  });
+  client->connected.connect([&](auto&&) {
+    connected.increment();
+  });
+
+  server->async_start();
+
+  double result = 0.0;
+
+  if (connected.wait(1)) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < report_count; i += window_size) {
+      auto end = std::min(i + window_size, report_count);
+
+      for (size_t j = i; j < end; ++j) {
+        switch (m) {
+          case mode::request:
+            client->async_request(payload, [&](auto&&, auto&&) {
+              responded.increment();
+            });
+            break;
+
+          case mode::send:
+            client->async_send(payload);
+            break;
+        }
+      }
+
+      if (!received.wait(end) ||
+          (m == mode::request && !responded.wait(end))) {
+        break;
+      }
+
+      if (end == report_count) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result = report_count / elapsed.count();
+      }
+    }
+  }
+
+  client = nullptr;
+  server = nullptr;
+
+  return result;
+}
+} // namespace post_report_benchmark
+
+void run_post_report_benchmark() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "post_report"_test = [] {
+    auto request_reports_per_second = post_report_benchmark::measure(post_report_benchmark::mode::request);
+    auto send_reports_per_second = post_report_benchmark::measure(post_report_benchmark::mode::send);
+
+    std::cout << "post_report (request/response): " << static_cast<uint64_t>(request_reports_per_second) << " reports/sec" << std::endl;
+    std::cout << "post_report (one-way send): " << static_cast<uint64_t>(send_reports_per_second) << " reports/sec" << std::endl;
+
+    expect(request_reports_per_second > 0.0);
+    expect(send_reports_per_second > 0.0);
+  };
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <pqrs/dispatcher.hpp>
+#include <report_worker_pool.hpp>
+#include <thread>
+#include <vector>
+
+namespace report_strand_benchmark {
+constexpr size_t client_count = 32;
+constexpr size_t round_count = 500;
+constexpr auto round_interval = std::chrono::milliseconds(1);
+
+// The driver call of the first client is blocked for `slow_call_duration`.
+// The driver calls of other clients take `call_duration`.
+constexpr auto slow_call_duration = std::chrono::microseconds(500);
+constexpr auto call_duration = std::chrono::microseconds(1);
+
+constexpr size_t worker_thread_count = 4;
+
+struct result final {
+  std::chrono::nanoseconds p50;
+  std::chrono::nanoseconds p99;
+  std::chrono::nanoseconds max;
+};
+
+class client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  client()
+      : dispatcher_client(pqrs::dispatcher::extra::get_shared_dispatcher()) {
+  }
+
+  ~client() override {
+    detach_from_dispatcher();
+  }
+
+  void wait() {
+    std::promise<void> promise;
+    enqueue_to_dispatcher([&promise] {
+      promise.set_value();
+    });
+    promise.get_future().wait();
+  }
+};
+
+inline void call_driver(size_t client_index) {
+  if (client_index == 0) {
+    std::this_thread::sleep_for(slow_call_duration);
+    return;
+  }
+
+  auto end = std::chrono::steady_clock::now() + call_duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+// Each client posts a report every `round_interval`.
+// Returns the latencies from posting a report to the end of the driver call, excluding the slow client.
+template <typename Post, typename Wait>
+result measure(Post post, Wait wait) {
+  std::vector<std::vector<std::chrono::nanoseconds>> latencies(client_count,
+                                                              std::vector<std::chrono::nanoseconds>(round_count));
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t round = 0; round < round_count; ++round) {
+    std::this_thread::sleep_until(start + round * round_interval);
+
+    for (size_t i = 0; i < client_count; ++i) {
+      post(i, [&latencies, i, round, posted_time = std::chrono::steady_clock::now()] {
+        call_driver(i);
+        latencies[i][round] = std::chrono::steady_clock::now() - posted_time;
+      });
+    }
+  }
+
+  wait();
+
+  std::vector<std::chrono::nanoseconds> values;
+  for (size_t i = 1; i < client_count; ++i) {
+    values.insert(std::end(values),
+                  std::begin(latencies[i]),
+                  std::end(latencies[i]));
+  }
+  std::ranges::sort(values);
+
+  return result{
+      .p50 = values[values.size() * 50 / 100],
+      .p99 = values[values.size() * 99 / 100],
+      .max = values.back(),
+  };
+}
+
+inline void print(const char* name, const result& r) {
+  std::cout << "report path with " << client_count << " clients and a slow client (" << name << "): "
+            << "p50 " << r.p50.count() / 1000.0 << " us, "
+            << "p99 " << r.p99.count() / 1000.0 << " us, "
+            << "max " << r.max.count() / 1000.0 << " us" << std::endl;
+}
+} // namespace report_strand_benchmark
+
+void run_report_strand_benchmark() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "report_strand"_test = [] {
+    using namespace report_strand_benchmark;
+
+    // The previous implementation which calls the driver of every client in the shared dispatcher thread.
+    client c;
+    auto shared_dispatcher = measure(
+        [&c](auto, auto&& function) {
+          c.enqueue_to_dispatcher(function);
+        },
+        [&c] {
+          c.wait();
+        });
+
+    report_worker_pool pool(worker_thread_count);
+    std::vector<report_worker_pool::strand> strands;
+    for (size_t i = 0; i < client_count; ++i) {
+      strands.push_back(pool.make_strand());
+    }
+    auto strand = measure(
+        [&strands](auto i, auto&& function) {
+          strands[i].post(function);
+        },
+        [&strands] {
+          for (const auto& s : strands) {
+            report_worker_pool::wait(s);
+          }
+        });
+
+    print("shared dispatcher", shared_dispatcher);
+    print("per-client strand", strand);
+
+    expect(shared_dispatcher.p99.count() > 0);
+    expect(strand.p99.count() > 0);
+  };
+}
@@ -0,0 +1,151 @@
+#include <boost/ut.hpp>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <pqrs/unix_domain_stream.hpp>
+
+namespace request_manager_benchmark {
+constexpr size_t outstanding_request_count = 10000;
+constexpr size_t iteration_count = 20;
+constexpr auto timeout = std::chrono::milliseconds(5000);
+
+// The previous implementation which allocates a steady_timer for each pending request.
+class timer_per_request_manager final {
+public:
+  timer_per_request_manager(asio::io_context& io_ctx,
+                            pqrs::dispatcher::extra::dispatcher_client& dispatcher_client)
+      : io_ctx_(io_ctx),
+        dispatcher_client_(dispatcher_client) {
+  }
+
+  pqrs::unix_domain_stream::request_id add(std::optional<pqrs::unix_domain_stream::peer_id> peer_id_value,
+                                           std::chrono::milliseconds timeout,
+                                           pqrs::unix_domain_stream::async_request_callback request_callback) {
+    auto id = ++next_request_id_;
+    auto timer = std::make_shared<asio::steady_timer>(io_ctx_);
+    timer->expires_after(timeout);
+    timer->async_wait([this, id](const auto& error_code) {
+      if (!error_code) {
+        complete(id, asio::error::timed_out, nullptr);
+      }
+    });
+
+    pending_requests_.emplace(id,
+                              pending_request{
+                                  .peer_id_value = peer_id_value,
+                                  .callback = request_callback,
+                                  .timer = timer,
+                              });
+
+    return id;
+  }
+
+  void complete(pqrs::unix_domain_stream::request_id id,
+                const asio::error_code& error_code,
+                std::shared_ptr<std::vector<uint8_t>> data) {
+    if (auto node = pending_requests_.extract(id);
+        !node.empty()) {
+      auto request = std::move(node.mapped());
+
+      request.timer->cancel();
+      dispatcher_client_.enqueue_to_dispatcher([request, error_code, data] {
+        request.callback(error_code, data);
+      });
+    }
+  }
+
+private:
+  struct pending_request final {
+    std::optional<pqrs::unix_domain_stream::peer_id> peer_id_value;
+    pqrs::unix_domain_stream::async_request_callback callback;
+    std::shared_ptr<asio::steady_timer> timer;
+  };
+
+  asio::io_context& io_ctx_;
+  pqrs::dispatcher::extra::dispatcher_client& dispatcher_client_;
+  pqrs::unix_domain_stream::request_id next_request_id_ = 0;
+  std::unordered_map<pqrs::unix_domain_stream::request_id, pending_request> pending_requests_;
+};
+
+class client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  client()
+      : dispatcher_client(pqrs::dispatcher::extra::get_shared_dispatcher()) {
+  }
+
+  ~client() override {
+    detach_from_dispatcher();
+  }
+
+  void wait() {
+    std::promise<void> promise;
+    enqueue_to_dispatcher([&promise] {
+      promise.set_value();
+    });
+    promise.get_future().wait();
+  }
+};
+
+// Returns nanoseconds per request.
+// Each iteration registers `outstanding_request_count` requests, then completes them in the response order.
+template <typename T>
+double measure() {
+  client c;
+  asio::io_context io_ctx;
+  T manager(io_ctx, c);
+
+  size_t completed_count = 0;
+  std::vector<pqrs::unix_domain_stream::request_id> ids;
+  ids.reserve(outstanding_request_count);
+
+  std::chrono::nanoseconds elapsed(0);
+
+  for (size_t i = 0; i < iteration_count; ++i) {
+    ids.clear();
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t j = 0; j < outstanding_request_count; ++j) {
+      ids.push_back(manager.add(std::nullopt,
+                                timeout,
+                                [&completed_count](auto&&, auto&&) {
+                                  ++completed_count;
+                                }));
+    }
+
+    for (const auto& id : ids) {
+      manager.complete(id, {}, nullptr);
+    }
+
+    // Run the cancelled timer handlers.
+    io_ctx.restart();
+    io_ctx.poll();
+
+    elapsed += std::chrono::steady_clock::now() - start;
+
+    c.wait();
+  }
+
+  if (completed_count != outstanding_request_count * iteration_count) {
+    std::cout << "unexpected completed_count" << std::endl;
+  }
+
+  return static_cast<double>(elapsed.count()) / (outstanding_request_count * iteration_count);
+}
+} // namespace request_manager_benchmark
+
+void run_request_manager_benchmark() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "request_manager"_test = [] {
+    auto timer_per_request = request_manager_benchmark::measure<request_manager_benchmark::timer_per_request_manager>();
+    auto timing_wheel = request_manager_benchmark::measure<pqrs::unix_domain_stream::impl::request_manager>();
+
+    std::cout << "request_manager with " << request_manager_benchmark::outstanding_request_count << " outstanding requests (timer per request): " << timer_per_request << " ns/request" << std::endl;
+    std::cout << "request_manager with " << request_manager_benchmark::outstanding_request_count << " outstanding requests (timing wheel): " << timing_wheel << " ns/request" << std::endl;
+
+    expect(timer_per_request > 0.0);
+    expect(timing_wheel > 0.0);
+  };
+}
@@ -0,0 +1,24 @@
+#include "dispatcher_contention_benchmark.hpp"
+#include "dispatcher_priority_benchmark.hpp"
+#include "dispatcher_timer_benchmark.hpp"
+#include "driver_status_benchmark.hpp"
+#include "frame_benchmark.hpp"
+#include "post_report_benchmark.hpp"
+#include "report_strand_benchmark.hpp"
+#include "request_manager_benchmark.hpp"
+
+int main() {
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  run_frame_benchmark();
+  run_post_report_benchmark();
+  run_request_manager_benchmark();
+  run_report_strand_benchmark();
+  run_dispatcher_timer_benchmark();
+  run_dispatcher_contention_benchmark();
+  run_dispatcher_priority_benchmark();
+  run_driver_status_benchmark();
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  return 0;
+}
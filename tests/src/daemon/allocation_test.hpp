@@ -0,0 +1,93 @@
+#include "allocation_counter.hpp"
+#include "dispatcher_runner.hpp"
+#include "loopback_daemon.hpp"
+#include <boost/ut.hpp>
+#include <chrono>
+#include <thread>
+
+void run_allocation_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "post report path does not allocate"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+
+    constexpr size_t warm_up_count = 1000;
+    constexpr size_t report_count = 1000;
+
+    // The server accepts connections on a listening socket as it does with socket activation,
+    // so that the socket path health check does not run while allocations are counted.
+    // The sink reuses its records after `warm_up_count` reports.
+    loopback_daemon daemon("allocation_test",
+                           {
+                               .listening_socket = true,
+                               .report_sink_capacity = 64,
+                           });
+    expect(daemon.get_listening_socket() != std::optional<int>(-1));
+    auto sink = daemon.get_report_sink();
+    daemon.start_server();
+
+    loopback_daemon_client c(daemon);
+    auto& client = c.get();
+    c.async_start();
+
+    expect(c.wait_ready());
+
+    virtual_hid_device_driver::hid_report::keyboard_input keyboard_input;
+    keyboard_input.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+
+    virtual_hid_device_driver::hid_report::pointing_input pointing_input;
+    pointing_input.x = 10;
+
+    // Count the allocations from `client::async_post_report` to the driver backend,
+    // which run in this thread, the dispatcher thread and the report strands.
+    // The io threads which write and read the frames are not counted as in `client_allocation_test`.
+    dispatcher_runner r;
+    r.run([] {
+      allocation_counter::marked_thread = true;
+    });
+    allocation_counter::marked_thread = true;
+
+    // The report strands run in the worker threads of the daemon, so they are marked while warming up.
+    auto connection = sink->recorded.connect([](auto&&) {
+      allocation_counter::marked_thread = true;
+    });
+
+    auto post = [&](size_t n) {
+      for (size_t i = 0; i < n; ++i) {
+        auto recorded_count = sink->get_recorded_count();
+
+        client.async_post_report(keyboard_input);
+        client.async_post_report(pointing_input);
+
+        if (!wait_until([&] {
+              return sink->get_recorded_count() >= recorded_count + 2;
+            })) {
+          return;
+        }
+
+        // Let the io and worker threads return buffers and leave the strand before the next report,
+        // so that each report is posted to an idle path as the warm-up reports are.
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    };
+
+    post(warm_up_count);
+
+    connection.disconnect();
+
+    auto count = allocation_counter::count_marked_thread_allocations([&] {
+      post(report_count);
+    });
+
+    expect(count == 0_ul);
+    expect(sink->get_records().size() == 64_ul);
+    expect(sink->get_records().back().report == std::vector<uint8_t>(reinterpret_cast<const uint8_t*>(&pointing_input),
+                                                                      reinterpret_cast<const uint8_t*>(&pointing_input) + sizeof(pointing_input)));
+
+    allocation_counter::marked_thread = false;
+    r.run([] {
+      allocation_counter::marked_thread = false;
+    });
+  };
+}
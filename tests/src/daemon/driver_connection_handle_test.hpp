@@ -0,0 +1,56 @@
+#include "driver_connection_handle.hpp"
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <thread>
+
+void run_driver_connection_handle_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "driver_connection_handle"_test = [] {
+    driver_connection_handle<unsigned int> handle;
+
+    auto get = [&handle] {
+      return handle.call([](auto h) { return static_cast<int>(h); },
+                         -1);
+    };
+
+    expect(get() == -1_i);
+
+    handle.publish(42);
+    expect(get() == 42_i);
+
+    handle.unpublish();
+    expect(get() == -1_i);
+  };
+
+  "driver_connection_handle unpublish waits for calls"_test = [] {
+    driver_connection_handle<unsigned int> handle;
+    handle.publish(1);
+
+    std::atomic<bool> entered = false;
+    std::atomic<bool> finished = false;
+
+    std::thread caller([&] {
+      handle.call(
+          [&](auto) {
+            entered = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            finished = true;
+            return 0;
+          },
+          -1);
+    });
+
+    while (!entered) {
+      std::this_thread::yield();
+    }
+
+    // The connection is closed after `unpublish` returns, so the call must have finished.
+    handle.unpublish();
+    expect(finished.load());
+
+    caller.join();
+  };
+}
@@ -0,0 +1,79 @@
+#include "driver_status.hpp"
+#include <boost/ut.hpp>
+
+void run_driver_status_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "driver_status"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+
+    driver_status status;
+
+    {
+      auto s = status.get_snapshot();
+      expect(s.driver_version == std::nullopt);
+      expect(!s.driver_version_mismatched);
+      expect(s.virtual_hid_keyboard_ready == std::nullopt);
+      expect(s.virtual_hid_pointing_ready == std::nullopt);
+
+      expect(!status.driver_connected());
+      expect(!status.driver_version_mismatched());
+      expect(!status.driver_usable());
+    }
+
+    // The readiness is not returned until the driver is connected.
+    expect(status.set_virtual_hid_keyboard_ready(true));
+    expect(!status.set_virtual_hid_keyboard_ready(true));
+    expect(status.get_virtual_hid_keyboard_ready() == std::nullopt);
+    expect(status.get_snapshot().virtual_hid_keyboard_ready == std::optional<bool>(true));
+
+    expect(status.set_driver_version(driver_version::embedded_driver_version));
+    expect(!status.set_driver_version(driver_version::embedded_driver_version));
+    expect(status.driver_connected());
+    expect(!status.driver_version_mismatched());
+    expect(status.driver_usable());
+    expect(status.get_snapshot().driver_version == std::optional(driver_version::embedded_driver_version));
+
+    expect(status.get_virtual_hid_keyboard_ready() == std::optional<bool>(true));
+    expect(status.get_virtual_hid_pointing_ready() == std::nullopt);
+
+    expect(status.set_virtual_hid_pointing_ready(false));
+    expect(status.get_virtual_hid_pointing_ready() == std::optional<bool>(false));
+    expect(status.set_virtual_hid_pointing_ready(true));
+    expect(status.get_virtual_hid_pointing_ready() == std::optional<bool>(true));
+    expect(status.get_virtual_hid_keyboard_ready() == std::optional<bool>(true));
+
+    // Mismatched version
+    auto mismatched_version = driver_version::value_t(type_safe::get(driver_version::embedded_driver_version) + 1);
+    expect(status.set_driver_version(mismatched_version));
+    expect(status.driver_connected());
+    expect(status.driver_version_mismatched());
+    expect(!status.driver_usable());
+    expect(status.get_snapshot().driver_version == std::optional(mismatched_version));
+    expect(status.get_virtual_hid_keyboard_ready() == std::nullopt);
+    expect(status.get_virtual_hid_pointing_ready() == std::nullopt);
+
+    // The full 64-bit version is kept.
+    auto large_version = driver_version::value_t(~uint64_t(0));
+    expect(status.set_driver_version(large_version));
+    expect(!status.set_driver_version(large_version));
+    expect(status.driver_version_mismatched());
+    expect(status.get_snapshot().driver_version == std::optional(large_version));
+
+    // Only the version is changed.
+    auto large_version2 = driver_version::value_t(uint64_t(1) << 60);
+    expect(status.set_driver_version(large_version2));
+    expect(status.get_snapshot().driver_version == std::optional(large_version2));
+
+    // Disconnected
+    expect(status.set_driver_version(std::nullopt));
+    expect(!status.driver_connected());
+    expect(!status.driver_version_mismatched());
+    expect(!status.driver_usable());
+
+    expect(status.set_virtual_hid_keyboard_ready(std::nullopt));
+    expect(status.get_snapshot().virtual_hid_keyboard_ready == std::nullopt);
+    expect(status.get_snapshot().virtual_hid_pointing_ready == std::optional<bool>(true));
+  };
+}
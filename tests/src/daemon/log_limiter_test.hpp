@@ -0,0 +1,94 @@
+#include "log_limiter.hpp"
+#include "logger.hpp"
+#include <boost/ut.hpp>
+#include <thread>
+#include <vector>
+
+void run_log_limiter_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "log_limiter acquire"_test = [] {
+    log_limiter limiter(std::chrono::seconds(10), 3);
+
+    std::chrono::steady_clock::time_point now(std::chrono::seconds(100));
+
+    expect(limiter.acquire(now) == std::optional<uint64_t>(0));
+    expect(limiter.acquire(now) == std::optional<uint64_t>(0));
+    expect(limiter.acquire(now) == std::optional<uint64_t>(0));
+    expect(limiter.acquire(now) == std::nullopt);
+    expect(limiter.acquire(now + std::chrono::seconds(9)) == std::nullopt);
+
+    // The suppressed count is returned with the next allowed message.
+    expect(limiter.acquire(now + std::chrono::seconds(10)) == std::optional<uint64_t>(2));
+    expect(limiter.acquire(now + std::chrono::seconds(10)) == std::optional<uint64_t>(0));
+
+    expect(log_limiter::make_suppressed_message(0) == "");
+    expect(log_limiter::make_suppressed_message(2) == " (2 similar messages were suppressed)");
+  };
+
+  "log_limiter acquire(key)"_test = [] {
+    log_limiter limiter(std::chrono::seconds(10), 100);
+
+    std::chrono::steady_clock::time_point now(std::chrono::seconds(100));
+
+    expect(limiter.acquire(1, now) == std::optional<uint64_t>(0));
+    expect(limiter.acquire(1, now) == std::nullopt);
+    expect(limiter.acquire(1, now + std::chrono::seconds(5)) == std::nullopt);
+
+    // A different key is allowed.
+    expect(limiter.acquire(2, now + std::chrono::seconds(5)) == std::optional<uint64_t>(2));
+    expect(limiter.acquire(1, now + std::chrono::seconds(5)) == std::optional<uint64_t>(0));
+
+    // The same key is allowed after the interval.
+    expect(limiter.acquire(1, now + std::chrono::seconds(10)) == std::nullopt);
+    expect(limiter.acquire(1, now + std::chrono::seconds(15)) == std::optional<uint64_t>(1));
+  };
+
+  "log_limiter threads"_test = [] {
+    log_limiter limiter(std::chrono::hours(1), 10);
+
+    // Start the window.
+    expect(limiter.acquire() == std::optional<uint64_t>(0));
+
+    std::atomic<uint64_t> allowed_count = 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < 10000; ++j) {
+          if (limiter.acquire()) {
+            ++allowed_count;
+          }
+        }
+      });
+    }
+    for (auto&& t : threads) {
+      t.join();
+    }
+
+    expect(allowed_count.load() == 9_ul);
+  };
+
+  "logger::get_logger threads"_test = [] {
+    auto expected = logger::get_logger().get().get();
+
+    std::atomic<bool> same = true;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < 10000; ++j) {
+          if (logger::get_logger().get().get() != expected) {
+            same = false;
+          }
+        }
+      });
+    }
+    for (auto&& t : threads) {
+      t.join();
+    }
+
+    expect(same.load());
+  };
+}
@@ -0,0 +1,258 @@
+#include "loopback_daemon.hpp"
+#include "virtual_hid_device_service_clients_manager.hpp"
+#include <boost/ut.hpp>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace loopback_driver_backend_test {
+using request = pqrs::karabiner::driverkit::virtual_hid_device_service::request;
+using response = pqrs::karabiner::driverkit::virtual_hid_device_service::response;
+using user_client_method = pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method;
+
+constexpr pqrs::unix_domain_stream::peer_id peer_id = 1;
+
+// Run the manager in the dispatcher thread as the server does.
+class manager_runner final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  manager_runner() {
+    run([this] {
+      manager_ = std::make_unique<virtual_hid_device_service_clients_manager>(weak_dispatcher_,
+                                                                              backend_);
+      manager_->status_changed.connect([this](auto&&, auto&& status) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_ = status;
+      });
+    });
+  }
+
+  ~manager_runner() override {
+    detach_from_dispatcher([this] {
+      manager_ = nullptr;
+    });
+  }
+
+  pqrs::not_null_shared_ptr_t<loopback_driver_backend> get_backend() const {
+    return backend_;
+  }
+
+  void run(std::function<void()> function) {
+    std::promise<void> promise;
+    enqueue_to_dispatcher([&] {
+      function();
+      promise.set_value();
+    });
+    promise.get_future().wait();
+  }
+
+  virtual_hid_device_service_clients_manager& get_manager() {
+    return *manager_;
+  }
+
+  // Wait until both devices are ready, and return the elapsed time.
+  std::optional<std::chrono::milliseconds> wait_ready(std::chrono::steady_clock::time_point start) const {
+    auto ready = wait_until(
+        [this] {
+          std::lock_guard<std::mutex> lock(mutex_);
+
+          return status_value(response::virtual_hid_keyboard_ready) &&
+                 status_value(response::virtual_hid_pointing_ready);
+        },
+        std::chrono::milliseconds(3000));
+    if (!ready) {
+      return std::nullopt;
+    }
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  }
+
+  std::vector<loopback_report_sink::record> wait_records(uint64_t count) const {
+    wait_until(
+        [this, count] {
+          return backend_->get_report_sink()->get_recorded_count() >= count;
+        },
+        std::chrono::milliseconds(3000));
+
+    return backend_->get_report_sink()->get_records();
+  }
+
+private:
+  // `mutex_` must be locked.
+  bool status_value(response r) const {
+    for (size_t i = 0; i + 1 < status_.size(); i += 2) {
+      if (status_[i] == std::to_underlying(r)) {
+        return status_[i + 1];
+      }
+    }
+    return false;
+  }
+
+  pqrs::not_null_shared_ptr_t<loopback_driver_backend> backend_ = std::make_shared<loopback_driver_backend>();
+  std::unique_ptr<virtual_hid_device_service_clients_manager> manager_;
+
+  mutable std::mutex mutex_;
+  std::vector<uint8_t> status_;
+};
+
+template <typename T>
+std::shared_ptr<std::vector<uint8_t>> make_buffer(const T& report) {
+  auto buffer = std::make_shared<std::vector<uint8_t>>(sizeof(report));
+  std::memcpy(buffer->data(), &report, sizeof(report));
+  return buffer;
+}
+} // namespace loopback_driver_backend_test
+
+void run_loopback_driver_backend_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+  using namespace loopback_driver_backend_test;
+
+  "loopback_driver_backend"_test = [] {
+    manager_runner r;
+    auto sink = r.get_backend()->get_report_sink();
+
+    //
+    // Devices become ready on device notifications without waiting for the polling interval.
+    //
+
+    auto start = std::chrono::steady_clock::now();
+
+    r.run([&] {
+      r.get_manager().create_client(peer_id);
+      r.get_manager().initialize_keyboard(peer_id,
+                                          pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters());
+      r.get_manager().initialize_pointing(peer_id);
+    });
+
+    auto elapsed = r.wait_ready(start);
+    expect(elapsed != std::nullopt);
+    if (elapsed) {
+      expect(*elapsed < virtual_hid_device_service_clients_manager::ready_polling_interval);
+    }
+
+    //
+    // Reports and resets are recorded in the received order.
+    //
+
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input keyboard_input;
+    keyboard_input.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input pointing_input;
+    pointing_input.x = 10;
+    pointing_input.y = 20;
+
+    r.run([&] {
+      r.get_manager().post_keyboard_report(peer_id,
+                                           request::post_keyboard_input_report,
+                                           &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_keyboard_input_reports,
+                                           make_buffer(keyboard_input),
+                                           0,
+                                           sizeof(keyboard_input),
+                                           user_client_method::virtual_hid_keyboard_post_report,
+                                           "post_keyboard_input_report");
+      r.get_manager().virtual_hid_keyboard_reset(peer_id);
+      r.get_manager().post_pointing_report(peer_id,
+                                           request::post_pointing_input_report,
+                                           &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_pointing_input_reports,
+                                           make_buffer(pointing_input),
+                                           0,
+                                           sizeof(pointing_input),
+                                           user_client_method::virtual_hid_pointing_post_report,
+                                           "post_pointing_input_report");
+    });
+
+    auto records = r.wait_records(3);
+    expect(records.size() == 3_ul);
+    if (records.size() == 3) {
+      expect(records[0].user_client_method == user_client_method::virtual_hid_keyboard_post_report);
+      expect(records[0].report == *make_buffer(keyboard_input));
+      expect(records[1].user_client_method == user_client_method::virtual_hid_keyboard_reset);
+      expect(records[1].report.empty());
+      expect(records[2].user_client_method == user_client_method::virtual_hid_pointing_post_report);
+      expect(records[2].report == *make_buffer(pointing_input));
+      expect(records[0].recorded_time <= records[2].recorded_time);
+    }
+
+    //
+    // Reports to terminated devices are dropped.
+    //
+
+    r.run([&] {
+      r.get_manager().terminate_pointing(peer_id);
+    });
+    r.run([&] {
+      r.get_manager().post_pointing_report(peer_id,
+                                           request::post_pointing_input_report,
+                                           &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_pointing_input_reports,
+                                           make_buffer(pointing_input),
+                                           0,
+                                           sizeof(pointing_input),
+                                           user_client_method::virtual_hid_pointing_post_report,
+                                           "post_pointing_input_report");
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    expect(sink->get_recorded_count() == 3_ul);
+
+    r.run([&] {
+      r.get_manager().erase_client(peer_id);
+    });
+  };
+
+  "release driver client during slow driver call"_test = [] {
+    manager_runner r;
+    auto sink = r.get_backend()->get_report_sink();
+
+    r.run([&] {
+      r.get_manager().create_client(peer_id);
+      r.get_manager().initialize_keyboard(peer_id,
+                                          pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters());
+      r.get_manager().initialize_pointing(peer_id);
+    });
+
+    expect(r.wait_ready(std::chrono::steady_clock::now()) != std::nullopt);
+
+    // Block the report strand of the peer in a driver call.
+    std::promise<void> call_started;
+    std::promise<void> call_finished;
+    auto call_finished_future = call_finished.get_future().share();
+    auto connection = sink->recorded.connect([&, call_finished_future](auto&&) {
+      call_started.set_value();
+      call_finished_future.wait();
+    });
+
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input keyboard_input;
+
+    r.run([&] {
+      r.get_manager().post_keyboard_report(peer_id,
+                                           request::post_keyboard_input_report,
+                                           &pqrs::karabiner::driverkit::virtual_hid_device_service::statistics::received_keyboard_input_reports,
+                                           make_buffer(keyboard_input),
+                                           0,
+                                           sizeof(keyboard_input),
+                                           user_client_method::virtual_hid_keyboard_post_report,
+                                           "post_keyboard_input_report");
+    });
+
+    call_started.get_future().wait();
+
+    // Releasing the driver clients does not wait for the driver call in the dispatcher thread.
+    auto released = std::async(std::launch::async, [&] {
+      r.run([&] {
+        r.get_manager().terminate_keyboard(peer_id);
+      });
+      r.run([&] {
+        r.get_manager().erase_client(peer_id);
+      });
+    });
+    expect(released.wait_for(std::chrono::seconds(3)) == std::future_status::ready);
+
+    connection.disconnect();
+    call_finished.set_value();
+    released.wait();
+
+    expect(r.wait_records(1).size() == 1_ul);
+  };
+}
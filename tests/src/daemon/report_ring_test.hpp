@@ -0,0 +1,117 @@
+#include "loopback_daemon.hpp"
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+void run_report_ring_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "report ring with coalesce_reports"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+
+    constexpr size_t burst_count = 2000;
+    constexpr size_t report_count = 10;
+
+    loopback_daemon daemon("report_ring_test");
+    auto sink = daemon.get_report_sink();
+    daemon.start_server();
+
+    loopback_daemon_client c(daemon,
+                             {
+                                 .coalesce_reports = true,
+                                 .report_ring = true,
+                             },
+                             {
+                                 .keyboard = false,
+                             });
+    auto& client = c.get();
+
+    std::mutex statistics_mutex;
+    std::optional<virtual_hid_device_service::statistics> statistics;
+    std::atomic<size_t> statistics_count = 0;
+    client.statistics_received.connect([&](auto&& value) {
+      {
+        std::lock_guard<std::mutex> lock(statistics_mutex);
+        statistics = value;
+      }
+      ++statistics_count;
+    });
+
+    // Returns the number of reports which the daemon has received through the ring.
+    auto get_report_ring_reports = [&]() -> std::optional<uint64_t> {
+      auto count = statistics_count.load();
+      client.async_get_statistics();
+      if (!wait_until([&] {
+            return statistics_count > count;
+          })) {
+        return std::nullopt;
+      }
+
+      std::lock_guard<std::mutex> lock(statistics_mutex);
+      return statistics->received_report_ring_reports;
+    };
+
+    c.async_start();
+
+    expect(c.wait_ready());
+
+    virtual_hid_device_driver::hid_report::pointing_input report;
+    report.x = 1;
+
+    // Wait until the client posts reports through the ring.
+    expect(wait_until([&] {
+      auto recorded_count = sink->get_recorded_count();
+      client.async_post_report(report);
+      if (!wait_until([&] {
+            return sink->get_recorded_count() > recorded_count;
+          })) {
+        return false;
+      }
+
+      return get_report_ring_reports().value_or(0) > 0;
+    }));
+
+    // Post a burst which overflows the ring,
+    // so that the reports are sent through the socket and merged in the send queue.
+
+    for (size_t i = 0; i < burst_count; ++i) {
+      client.async_post_report(report);
+    }
+
+    // Wait until the burst is handled.
+    size_t recorded_count = 0;
+    wait_until([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      auto count = sink->get_recorded_count();
+      if (count == recorded_count) {
+        return true;
+      }
+      recorded_count = count;
+      return false;
+    });
+
+    // Some reports are merged.
+    expect(recorded_count < burst_count);
+
+    recorded_count = sink->get_recorded_count();
+    auto report_ring_reports = get_report_ring_reports();
+    expect(report_ring_reports != std::nullopt);
+
+    // The following reports are posted through the ring, not as socket messages.
+    for (size_t i = 0; i < report_count; ++i) {
+      client.async_post_report(report);
+
+      expect(wait_until([&] {
+        return sink->get_recorded_count() == recorded_count + i + 1;
+      }));
+    }
+
+    expect(get_report_ring_reports() == std::optional<uint64_t>(report_ring_reports.value_or(0) + report_count));
+
+    client.async_stop();
+  };
+}
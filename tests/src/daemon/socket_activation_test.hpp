@@ -0,0 +1,99 @@
+#include "loopback_daemon.hpp"
+#include "socket_activation.hpp"
+#include <boost/ut.hpp>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+
+void run_socket_activation_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+#ifndef __APPLE__
+  "socket_activation LISTEN_FDS"_test = [] {
+    expect(socket_activation::get_listening_socket() == std::nullopt);
+
+    auto socket_file_path = std::filesystem::temp_directory_path() / "virtual_hid_device_service_socket_activation_test" / "listen_fds.sock";
+    auto s = make_listening_socket(socket_file_path);
+    expect(s != -1_i);
+
+    // Pass the socket as the first `LISTEN_FDS` socket.
+    auto saved = dup(socket_activation::listen_fds_start);
+    dup2(s, socket_activation::listen_fds_start);
+    close(s);
+
+    setenv("LISTEN_PID", std::to_string(getpid()).c_str(), 1);
+    setenv("LISTEN_FDS", "1", 1);
+
+    expect(socket_activation::get_listening_socket() == std::optional<int>(socket_activation::listen_fds_start));
+    expect(std::getenv("LISTEN_PID") == nullptr);
+    expect(std::getenv("LISTEN_FDS") == nullptr);
+
+    // The sockets are consumed.
+    expect(socket_activation::get_listening_socket() == std::nullopt);
+
+    if (saved != -1) {
+      dup2(saved, socket_activation::listen_fds_start);
+      close(saved);
+    } else {
+      close(socket_activation::listen_fds_start);
+    }
+
+    std::error_code error_code;
+    std::filesystem::remove(socket_file_path, error_code);
+  };
+
+  "socket_activation LISTEN_PID mismatch"_test = [] {
+    setenv("LISTEN_PID", std::to_string(getpid() + 1).c_str(), 1);
+    setenv("LISTEN_FDS", "1", 1);
+
+    expect(socket_activation::get_listening_socket() == std::nullopt);
+
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+  };
+#endif
+
+  "virtual_hid_device_service_server with a listening socket"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+
+    loopback_daemon daemon("socket_activation_test",
+                           {
+                               .listening_socket = true,
+                           });
+    expect(daemon.get_listening_socket() != std::optional<int>(-1));
+
+    // The client connects before the daemon is started.
+    loopback_daemon_client c(daemon,
+                             {},
+                             {
+                                 .keyboard = false,
+                             });
+
+    auto start = std::chrono::steady_clock::now();
+    c.async_start();
+
+    daemon.start_server();
+
+    // The client does not wait for the reconnect interval.
+    expect(c.wait_ready(std::chrono::milliseconds(3000)));
+    expect(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+
+    virtual_hid_device_driver::hid_report::pointing_input report;
+    report.x = 10;
+    c.get().async_post_report(report);
+
+    auto sink = daemon.get_report_sink();
+    expect(wait_until([&] {
+      return sink->get_recorded_count() > 0;
+    }));
+    expect(sink->get_recorded_count() == 1_ul);
+
+    c.get().async_stop();
+    daemon.stop_server();
+
+    // The socket file belongs to the service manager.
+    expect(std::filesystem::exists(daemon.get_socket_file_path()));
+  };
+}
@@ -0,0 +1,24 @@
+#include "allocation_test.hpp"
+#include "driver_connection_handle_test.hpp"
+#include "driver_status_test.hpp"
+#include "log_limiter_test.hpp"
+#include "loopback_driver_backend_test.hpp"
+#include "report_ring_test.hpp"
+#include "socket_activation_test.hpp"
+#include "trace_log_test.hpp"
+
+int main() {
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  run_allocation_test();
+  run_driver_connection_handle_test();
+  run_driver_status_test();
+  run_log_limiter_test();
+  run_loopback_driver_backend_test();
+  run_report_ring_test();
+  run_socket_activation_test();
+  run_trace_log_test();
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  return 0;
+}
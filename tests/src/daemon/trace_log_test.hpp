@@ -0,0 +1,127 @@
+#include "trace_log.hpp"
+#include <boost/ut.hpp>
+#include <filesystem>
+#include <map>
+#include <thread>
+#include <vector>
+
+void run_trace_log_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "trace_log"_test = [] {
+    auto trace_file_path = std::filesystem::temp_directory_path() / "virtual_hid_device_service_trace_log_test";
+
+    constexpr size_t thread_count = 4;
+    constexpr uint64_t event_count = 1000;
+
+    {
+      auto t = trace_log::create(trace_file_path, 16 * 1024 * 1024);
+      expect(t != nullptr);
+
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&t, i] {
+          for (uint64_t j = 0; j < event_count; ++j) {
+            t->write(trace_event::report_forwarded, i, j, true, 1234);
+          }
+        });
+      }
+      for (auto&& thread : threads) {
+        thread.join();
+      }
+
+      // The remaining records are written in the destructor.
+    }
+
+    auto entries = trace_log::read(trace_file_path);
+    expect(entries != std::nullopt);
+    if (!entries) {
+      return;
+    }
+
+    expect(entries->size() == thread_count * event_count);
+
+    // The records of each thread are kept in order.
+    std::map<uint64_t, uint64_t> next_sequences;
+    bool ordered = true;
+    for (const auto& e : *entries) {
+      if (e.event != trace_event::report_forwarded ||
+          e.arguments.size() != 4) {
+        ordered = false;
+        break;
+      }
+
+      auto& next = next_sequences[e.arguments[0]];
+      if (e.arguments[1] != next) {
+        ordered = false;
+      }
+      ++next;
+    }
+    expect(ordered);
+    expect(next_sequences.size() == thread_count);
+
+    expect(trace_log::format(entries->front()) == "report_forwarded peer_id:" + std::to_string(entries->front().arguments[0]) +
+                                                      " request:0 success:1 latency_ns:1234");
+
+    // The previous file is kept on create.
+    {
+      auto t = trace_log::create(trace_file_path, 16 * 1024 * 1024);
+      t->write(trace_event::peer_closed, 5);
+    }
+
+    entries = trace_log::read(trace_file_path);
+    expect(entries != std::nullopt);
+    if (entries) {
+      expect(entries->size() == 1_ul);
+      expect(trace_log::format(entries->front()) == "peer_closed peer_id:5");
+    }
+
+    entries = trace_log::read(trace_log::get_previous_file_path(trace_file_path));
+    expect(entries != std::nullopt);
+    if (entries) {
+      expect(entries->size() == thread_count * event_count);
+    }
+
+    std::error_code error_code;
+    std::filesystem::remove(trace_file_path, error_code);
+    std::filesystem::remove(trace_log::get_previous_file_path(trace_file_path), error_code);
+  };
+
+  "trace_log events_dropped"_test = [] {
+    auto trace_file_path = std::filesystem::temp_directory_path() / "virtual_hid_device_service_trace_log_test";
+
+    constexpr uint64_t event_count = trace_log::thread_buffer_capacity * 4;
+
+    {
+      auto t = trace_log::create(trace_file_path, 16 * 1024 * 1024);
+
+      for (uint64_t i = 0; i < event_count; ++i) {
+        t->write(trace_event::request_received, 1, i);
+      }
+    }
+
+    auto entries = trace_log::read(trace_file_path);
+    expect(entries != std::nullopt);
+    if (!entries) {
+      return;
+    }
+
+    // Every event is either written or counted as dropped.
+    uint64_t written_count = 0;
+    uint64_t dropped_count = 0;
+    for (const auto& e : *entries) {
+      if (e.event == trace_event::request_received) {
+        ++written_count;
+      } else if (e.event == trace_event::events_dropped) {
+        dropped_count += e.arguments[1];
+      }
+    }
+    expect(written_count >= trace_log::thread_buffer_capacity);
+    expect(written_count + dropped_count == event_count);
+
+    std::error_code error_code;
+    std::filesystem::remove(trace_file_path, error_code);
+    std::filesystem::remove(trace_log::get_previous_file_path(trace_file_path), error_code);
+  };
+}
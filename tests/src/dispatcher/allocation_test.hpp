@@ -0,0 +1,119 @@
+#include "allocation_counter.hpp"
+#include <array>
+#include <atomic>
+#include <boost/ut.hpp>
+#include <memory>
+#include <pqrs/dispatcher.hpp>
+#include <thread>
+#include <vector>
+
+namespace allocation_test {
+class client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  explicit client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher)
+      : dispatcher_client(weak_dispatcher) {
+  }
+
+  ~client() override {
+    detach_from_dispatcher();
+  }
+};
+} // namespace allocation_test
+
+void run_allocation_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "task stores small functions inline"_test = [] {
+    auto buffer = std::make_shared<std::vector<uint8_t>>(32);
+    int value = 0;
+
+    auto count = allocation_counter::count_allocations([&] {
+      pqrs::dispatcher::task t([&value, id = uint64_t(1), buffer] {
+        value += static_cast<int>(id + buffer->size());
+      });
+      auto moved = std::move(t);
+      moved();
+    });
+
+    expect(count == 0_ul);
+    expect(value == 33_i);
+  };
+
+  "task stores large functions on the heap"_test = [] {
+    std::array<uint64_t, 16> large{};
+    large.back() = 42;
+    uint64_t value = 0;
+    bool moved_from_empty = false;
+
+    auto count = allocation_counter::count_allocations([&] {
+      pqrs::dispatcher::task t([&value, large] {
+        value = large.back();
+      });
+      auto moved = std::move(t);
+      moved_from_empty = !t;
+      moved();
+    });
+
+    expect(count == 1_ul);
+    expect(moved_from_empty);
+    expect(value == 42_ul);
+  };
+
+  "steady state enqueue does not allocate"_test = [] {
+    constexpr size_t warm_up_count = 1000;
+    constexpr size_t function_count = 10000;
+
+    auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+    auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+    std::atomic<size_t> executed_count = 0;
+
+    {
+      allocation_test::client c(dispatcher);
+
+      // The same capture shapes as the report path of unix_domain_stream::server and impl::peer.
+      auto buffer = std::make_shared<std::vector<uint8_t>>(64);
+      auto p = &c;
+      uint64_t id = 1;
+      uint64_t request_id = 2;
+
+      auto enqueue = [&](size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+          c.enqueue_to_dispatcher([&executed_count, id, buffer] {
+            executed_count += id;
+          });
+          c.enqueue_to_dispatcher([&executed_count, p, request_id, buffer] {
+            if (p) {
+              executed_count += request_id - 1;
+            }
+          });
+
+          // Keep the number of pending entries within the capacity of the entry pool.
+          while (executed_count + 64 < (i + 1) * 2) {
+            std::this_thread::yield();
+          }
+        }
+      };
+
+      enqueue(warm_up_count);
+      while (executed_count < warm_up_count * 2) {
+        std::this_thread::yield();
+      }
+
+      executed_count = 0;
+
+      auto count = allocation_counter::count_allocations([&] {
+        enqueue(function_count);
+        while (executed_count < function_count * 2) {
+          std::this_thread::yield();
+        }
+      });
+
+      expect(count == 0_ul);
+      expect(executed_count.load() == function_count * 2);
+    }
+
+    dispatcher->terminate();
+  };
+}
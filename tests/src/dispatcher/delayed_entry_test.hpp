@@ -0,0 +1,167 @@
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <pqrs/dispatcher.hpp>
+#include <thread>
+#include <vector>
+
+namespace delayed_entry_test {
+class client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  explicit client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher)
+      : dispatcher_client(weak_dispatcher) {
+  }
+
+  ~client() override {
+    detach_from_dispatcher();
+  }
+
+  void push(int value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.push_back(value);
+  }
+
+  std::vector<int> wait_results(size_t count) const {
+    for (int i = 0; i < 1000; ++i) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (results_.size() >= count) {
+          return results_;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return results_;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::vector<int> results_;
+};
+} // namespace delayed_entry_test
+
+void run_delayed_entry_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+  using namespace std::chrono_literals;
+
+  "delayed entries order"_test = [] {
+    auto time_source = std::make_shared<pqrs::dispatcher::pseudo_time_source>();
+    auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+    {
+      delayed_entry_test::client c(dispatcher);
+
+      auto now = time_source->now();
+
+      // Entries are executed in the order of `when`, and in the enqueued order if `when` is the same.
+      for (const auto& [value, delay] : {
+               std::pair{1, 300ms},
+               std::pair{2, 100ms},
+               std::pair{3, 200ms},
+               std::pair{4, 100ms},
+               std::pair{5, 300ms},
+               std::pair{6, 100ms},
+           }) {
+        c.enqueue_to_dispatcher(
+            [&c, value] {
+              c.push(value);
+            },
+            now + delay);
+      }
+
+      // Immediate entries are executed before delayed entries.
+      c.enqueue_to_dispatcher([&c] {
+        c.push(0);
+      });
+
+      expect(std::vector<int>{0} == c.wait_results(1));
+
+      time_source->set_now(now + 150ms);
+      dispatcher->invoke();
+      expect(std::vector<int>{0, 2, 4, 6} == c.wait_results(4));
+
+      time_source->set_now(now + 300ms);
+      dispatcher->invoke();
+      expect(std::vector<int>{0, 2, 4, 6, 3, 1, 5} == c.wait_results(7));
+    }
+
+    dispatcher->terminate();
+  };
+
+  "queue_depth"_test = [] {
+    auto time_source = std::make_shared<pqrs::dispatcher::pseudo_time_source>();
+    auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+    {
+      delayed_entry_test::client c(dispatcher);
+
+      auto now = time_source->now();
+
+      for (int i = 0; i < 10; ++i) {
+        c.enqueue_to_dispatcher(
+            [&c, &dispatcher] {
+              c.push(static_cast<int>(dispatcher->queue_depth()));
+            },
+            now + std::chrono::milliseconds(100 + i));
+      }
+
+      // The delayed entries are waiting when the immediate entry is taken.
+      c.enqueue_to_dispatcher([&c, &dispatcher] {
+        c.push(static_cast<int>(dispatcher->queue_depth()));
+      });
+
+      expect(std::vector<int>{10} == c.wait_results(1));
+
+      time_source->set_now(now + 1000ms);
+      dispatcher->invoke();
+      expect(std::vector<int>{10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0} == c.wait_results(11));
+    }
+
+    dispatcher->terminate();
+  };
+
+  "detach removes delayed entries"_test = [] {
+    auto time_source = std::make_shared<pqrs::dispatcher::pseudo_time_source>();
+    auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+    std::atomic<int> count = 0;
+
+    {
+      delayed_entry_test::client c1(dispatcher);
+      auto c2 = std::make_unique<delayed_entry_test::client>(dispatcher);
+
+      auto now = time_source->now();
+
+      for (int i = 0; i < 100; ++i) {
+        c1.enqueue_to_dispatcher(
+            [&count] {
+              ++count;
+            },
+            now + std::chrono::milliseconds(100 + i));
+        c2->enqueue_to_dispatcher(
+            [&count] {
+              count += 1000;
+            },
+            now + std::chrono::milliseconds(100 + i));
+      }
+
+      c2 = nullptr;
+
+      time_source->set_now(now + 1000ms);
+      dispatcher->invoke();
+
+      for (int i = 0; i < 1000 && count < 100; ++i) {
+        std::this_thread::sleep_for(1ms);
+      }
+    }
+
+    dispatcher->terminate();
+
+    expect(count.load() == 100_i);
+  };
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <pqrs/dispatcher.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace priority_test {
+class client final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  client()
+      : dispatcher_client(pqrs::dispatcher::extra::get_shared_dispatcher()) {
+  }
+
+  ~client() override {
+    detach_from_dispatcher();
+  }
+
+  // Block the dispatcher thread until `resume` is called, so that entries are queued while it is blocked.
+  void pause() {
+    std::promise<void> paused;
+    enqueue_to_dispatcher(
+        [this, &paused] {
+          paused.set_value();
+          resume_.get_future().wait();
+        },
+        pqrs::dispatcher::priority::high);
+    paused.get_future().wait();
+  }
+
+  void resume() {
+    resume_.set_value();
+  }
+
+  void wait(pqrs::dispatcher::priority priority) {
+    std::promise<void> promise;
+    enqueue_to_dispatcher(
+        [&promise] {
+          promise.set_value();
+        },
+        priority);
+    promise.get_future().wait();
+  }
+
+  void push(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.push_back(name);
+  }
+
+  std::vector<std::string> get_results() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return results_;
+  }
+
+private:
+  std::promise<void> resume_;
+  mutable std::mutex mutex_;
+  std::vector<std::string> results_;
+};
+} // namespace priority_test
+
+void run_priority_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+  using pqrs::dispatcher::priority;
+
+  "priority order"_test = [] {
+    priority_test::client c;
+
+    c.pause();
+
+    for (const auto& [name, p] : {
+             std::pair{"low1", priority::low},
+             std::pair{"normal1", priority::normal},
+             std::pair{"high1", priority::high},
+             std::pair{"low2", priority::low},
+             std::pair{"normal2", priority::normal},
+             std::pair{"high2", priority::high},
+         }) {
+      c.enqueue_to_dispatcher(
+          [&c, name] {
+            c.push(name);
+          },
+          p);
+    }
+
+    c.resume();
+    c.wait(priority::low);
+
+    expect(std::vector<std::string>{"high1", "high2", "normal1", "normal2", "low1", "low2"} == c.get_results());
+  };
+
+  "delayed entries do not block lower priorities"_test = [] {
+    priority_test::client c;
+
+    c.enqueue_to_dispatcher(
+        [&c] {
+          c.push("high");
+        },
+        priority::high,
+        c.when_now() + std::chrono::milliseconds(100));
+    c.enqueue_to_dispatcher(
+        [&c] {
+          c.push("low");
+        },
+        priority::low);
+
+    c.wait(priority::low);
+    expect(std::vector<std::string>{"low"} == c.get_results());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    expect(std::vector<std::string>{"low", "high"} == c.get_results());
+  };
+
+  "starvation"_test = [] {
+    priority_test::client c;
+
+    c.pause();
+
+    c.enqueue_to_dispatcher(
+        [&c] {
+          c.push("low");
+        },
+        priority::low);
+    for (int i = 0; i < pqrs::dispatcher::dispatcher::max_passed_over_count * 2; ++i) {
+      c.enqueue_to_dispatcher(
+          [&c] {
+            c.push("high");
+          },
+          priority::high);
+    }
+
+    c.resume();
+    c.wait(priority::low);
+
+    // The low priority entry is executed after it is passed over `max_passed_over_count` times.
+    auto results = c.get_results();
+    auto it = std::ranges::find(results, "low");
+    expect(it != std::end(results));
+    expect(std::distance(std::begin(results), it) == pqrs::dispatcher::dispatcher::max_passed_over_count);
+  };
+
+  "high priority under busy low priority queue"_test = [] {
+    constexpr int low_count = 4;
+
+    priority_test::client c;
+
+    c.pause();
+
+    // Each low priority entry enqueues a high priority entry while it is running,
+    // as a report arrives during housekeeping work.
+    for (int i = 0; i < low_count; ++i) {
+      c.enqueue_to_dispatcher(
+          [&c, i] {
+            c.push("low" + std::to_string(i));
+            c.enqueue_to_dispatcher(
+                [&c, i] {
+                  c.push("high" + std::to_string(i));
+                },
+                priority::high);
+          },
+          priority::low);
+    }
+
+    c.resume();
+    c.wait(priority::low);
+
+    // A high priority entry waits at most the running low priority entry.
+    expect(std::vector<std::string>{"low0", "high0", "low1", "high1", "low2", "high2", "low3", "high3"} == c.get_results());
+  };
+}
@@ -0,0 +1,14 @@
+#include "allocation_test.hpp"
+#include "delayed_entry_test.hpp"
+#include "priority_test.hpp"
+
+int main() {
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  run_allocation_test();
+  run_delayed_entry_test();
+  run_priority_test();
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  return 0;
+}
@@ -0,0 +1,451 @@
+#include "loopback_driver_backend.hpp"
+#include "virtual_hid_device_service_server.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+namespace e2e_latency_benchmark {
+// The daemon server, the driver backend and the clients run in this process.
+// The latency is measured from `client::async_post_report` (or `async_post_reports`) to the arrival at `loopback_report_sink`.
+
+enum class mix_type {
+  // Each client types `reports_per_round` key down and key up reports back-to-back.
+  typing_burst,
+  // Each client moves the pointer every 1 ms.
+  pointing_1khz,
+  // Each client posts `reports_per_round` keyboard reports with `async_post_reports`.
+  macro_batch,
+};
+
+struct mix_parameters final {
+  mix_type type;
+  std::string_view name;
+  std::chrono::milliseconds round_interval;
+  size_t reports_per_round;
+  size_t warm_up_round_count;
+  size_t round_count;
+  // The p99 latency gate when no baseline is stored.
+  // It is the time until the next report of the mix is expected, so a report which is delayed by a polling interval or a timer fails the gate.
+  std::chrono::microseconds p99_budget;
+};
+
+constexpr std::array<mix_parameters, 3> mixes{{
+    {mix_type::typing_burst, "typing_burst", std::chrono::milliseconds(25), 16, 4, 20, std::chrono::milliseconds(2)},
+    {mix_type::pointing_1khz, "pointing_1khz", std::chrono::milliseconds(1), 1, 50, 500, std::chrono::milliseconds(1)},
+    {mix_type::macro_batch, "macro_batch", std::chrono::milliseconds(25), 32, 4, 20, std::chrono::milliseconds(2)},
+}};
+
+constexpr std::array<size_t, 4> client_counts{1, 4, 16, 64};
+
+// The regression gate against a stored baseline.
+// p99 fails when it exceeds `baseline p99 * baseline_p99_tolerance + baseline_p99_slack`.
+// The slack absorbs the scheduling noise of µs-range latencies.
+constexpr double baseline_p99_tolerance = 1.5;
+constexpr auto baseline_p99_slack = std::chrono::microseconds(50);
+
+constexpr auto delivery_timeout = std::chrono::seconds(10);
+
+struct result final {
+  size_t report_count;
+  size_t delivered_count;
+  std::chrono::nanoseconds p50;
+  std::chrono::nanoseconds p99;
+  std::chrono::nanoseconds p999;
+  double reports_per_second;
+  // The CPU time of this process (the daemon server, the clients and the dispatcher).
+  std::chrono::microseconds cpu_time;
+};
+
+// Reports are tagged with the client index and the sequence number in their last 4 bytes,
+// which are the padding keys of `keyboard_input` and the axes of `pointing_input`.
+inline uint32_t make_tag(size_t client_index, size_t sequence) {
+  return static_cast<uint32_t>((client_index << 24) | (sequence & 0xffffff));
+}
+
+template <typename T>
+T make_report(uint32_t tag) {
+  T report;
+  static_assert(sizeof(report) >= sizeof(tag));
+  std::memcpy(reinterpret_cast<uint8_t*>(&report) + sizeof(report) - sizeof(tag), &tag, sizeof(tag));
+  return report;
+}
+
+// The p99 latency of each mix and client count, measured on the machine which runs the benchmark.
+// Each line of the file is `mix_name client_count p99_nanoseconds`.
+class baseline final {
+public:
+  void load(const std::filesystem::path& file_path) {
+    std::ifstream stream(file_path);
+
+    std::string mix_name;
+    size_t client_count = 0;
+    int64_t p99 = 0;
+    while (stream >> mix_name >> client_count >> p99) {
+      p99_[{mix_name, client_count}] = std::chrono::nanoseconds(p99);
+    }
+  }
+
+  bool save(const std::filesystem::path& file_path) const {
+    std::ofstream stream(file_path);
+
+    for (const auto& [key, p99] : p99_) {
+      stream << key.first << " " << key.second << " " << p99.count() << std::endl;
+    }
+
+    return static_cast<bool>(stream);
+  }
+
+  std::optional<std::chrono::nanoseconds> find_p99(std::string_view mix_name,
+                                                   size_t client_count) const {
+    auto it = p99_.find({std::string(mix_name), client_count});
+    if (it == std::end(p99_)) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  void set_p99(std::string_view mix_name,
+               size_t client_count,
+               std::chrono::nanoseconds p99) {
+    p99_[{std::string(mix_name), client_count}] = p99;
+  }
+
+private:
+  std::map<std::pair<std::string, size_t>, std::chrono::nanoseconds> p99_;
+};
+
+inline std::chrono::nanoseconds get_p99_budget(const mix_parameters& parameters,
+                                               std::optional<std::chrono::nanoseconds> baseline_p99) {
+  if (baseline_p99) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(*baseline_p99 * baseline_p99_tolerance) + baseline_p99_slack;
+  }
+
+  return parameters.p99_budget;
+}
+
+inline std::chrono::microseconds get_cpu_time() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+
+  auto to_microseconds = [](const timeval& t) {
+    return std::chrono::seconds(t.tv_sec) + std::chrono::microseconds(t.tv_usec);
+  };
+  return to_microseconds(usage.ru_utime) + to_microseconds(usage.ru_stime);
+}
+
+inline std::chrono::nanoseconds percentile(const std::vector<std::chrono::nanoseconds>& sorted_latencies,
+                                           double p) {
+  if (sorted_latencies.empty()) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  auto index = static_cast<size_t>(static_cast<double>(sorted_latencies.size()) * p);
+  return sorted_latencies[std::min(index, sorted_latencies.size() - 1)];
+}
+
+class session final {
+public:
+  session(size_t client_count,
+          const std::filesystem::path& socket_file_path)
+      : report_sink_(std::make_shared<loopback_report_sink>(0)),
+        run_state_(nullptr) {
+    report_sink_->recorded.connect([this](auto&& record) {
+      on_recorded(record);
+    });
+
+    server_ = std::make_unique<virtual_hid_device_service_server>(std::make_shared<loopback_driver_backend>(report_sink_),
+                                                                  socket_file_path);
+
+    for (size_t i = 0; i < client_count; ++i) {
+      auto p = std::make_unique<peer>(socket_file_path);
+      auto c = p->client.get();
+
+      c->connected.connect([c] {
+        c->async_virtual_hid_keyboard_initialize(pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters());
+        c->async_virtual_hid_pointing_initialize();
+      });
+      c->virtual_hid_keyboard_ready.connect([p = p.get()](auto&& ready) {
+        p->virtual_hid_keyboard_ready = ready;
+      });
+      c->virtual_hid_pointing_ready.connect([p = p.get()](auto&& ready) {
+        p->virtual_hid_pointing_ready = ready;
+      });
+      c->async_start();
+
+      peers_.push_back(std::move(p));
+    }
+  }
+
+  ~session() {
+    peers_.clear();
+    server_ = nullptr;
+  }
+
+  bool wait_ready() const {
+    auto deadline = std::chrono::steady_clock::now() + delivery_timeout;
+
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (std::ranges::all_of(peers_, [](auto&& p) {
+            return p->virtual_hid_keyboard_ready && p->virtual_hid_pointing_ready;
+          })) {
+        return true;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return false;
+  }
+
+  result run(const mix_parameters& parameters,
+             size_t round_count) {
+    run_state state(peers_.size(),
+                    parameters.reports_per_round * round_count);
+    run_state_ = &state;
+
+    auto cpu_time = get_cpu_time();
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t round = 0; round < round_count; ++round) {
+      std::this_thread::sleep_until(start + round * parameters.round_interval);
+
+      for (size_t i = 0; i < peers_.size(); ++i) {
+        post(parameters, state, i, round * parameters.reports_per_round);
+      }
+    }
+
+    auto report_count = state.sent_times.size() * state.sent_times.front().size();
+    auto deadline = std::chrono::steady_clock::now() + delivery_timeout;
+    while (state.delivered_count < report_count &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    cpu_time = get_cpu_time() - cpu_time;
+
+    run_state_ = nullptr;
+
+    // Wait for the reports which are being recorded.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(report_count);
+    for (const auto& v : state.latencies) {
+      std::ranges::copy_if(v, std::back_inserter(latencies), [](auto&& l) {
+        return l >= std::chrono::nanoseconds(0);
+      });
+    }
+    std::ranges::sort(latencies);
+
+    return result{
+        .report_count = report_count,
+        .delivered_count = latencies.size(),
+        .p50 = percentile(latencies, 0.5),
+        .p99 = percentile(latencies, 0.99),
+        .p999 = percentile(latencies, 0.999),
+        .reports_per_second = latencies.size() / elapsed.count(),
+        .cpu_time = cpu_time,
+    };
+  }
+
+private:
+  struct peer final {
+    explicit peer(const std::filesystem::path& socket_file_path)
+        : client(std::make_unique<pqrs::karabiner::driverkit::virtual_hid_device_service::client>(
+              pqrs::karabiner::driverkit::virtual_hid_device_service::client_options{
+                  .server_socket_file_path = socket_file_path,
+              })),
+          virtual_hid_keyboard_ready(false),
+          virtual_hid_pointing_ready(false) {
+    }
+
+    std::unique_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client> client;
+    std::atomic<bool> virtual_hid_keyboard_ready;
+    std::atomic<bool> virtual_hid_pointing_ready;
+  };
+
+  struct run_state final {
+    run_state(size_t client_count,
+              size_t report_count_per_client)
+        : sent_times(client_count, std::vector<std::chrono::steady_clock::time_point>(report_count_per_client)),
+          latencies(client_count, std::vector<std::chrono::nanoseconds>(report_count_per_client, std::chrono::nanoseconds(-1))),
+          delivered_count(0) {
+    }
+
+    // `sent_times` are written before the reports are posted, and read after the reports arrive.
+    std::vector<std::vector<std::chrono::steady_clock::time_point>> sent_times;
+    // Each element is written once in the report strand of the client.
+    std::vector<std::vector<std::chrono::nanoseconds>> latencies;
+    std::atomic<size_t> delivered_count;
+  };
+
+  void post(const mix_parameters& parameters,
+            run_state& state,
+            size_t client_index,
+            size_t first_sequence) {
+    using namespace pqrs::karabiner::driverkit;
+
+    auto& c = *(peers_[client_index]->client);
+    auto& sent_times = state.sent_times[client_index];
+
+    switch (parameters.type) {
+      case mix_type::typing_burst:
+        for (size_t i = 0; i < parameters.reports_per_round; ++i) {
+          auto sequence = first_sequence + i;
+          auto report = make_report<virtual_hid_device_driver::hid_report::keyboard_input>(make_tag(client_index, sequence));
+          if (i % 2 == 0) {
+            report.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a) + i / 2);
+          }
+
+          sent_times[sequence] = std::chrono::steady_clock::now();
+          c.async_post_report(report);
+        }
+        break;
+
+      case mix_type::pointing_1khz: {
+        auto report = make_report<virtual_hid_device_driver::hid_report::pointing_input>(make_tag(client_index, first_sequence));
+
+        sent_times[first_sequence] = std::chrono::steady_clock::now();
+        c.async_post_report(report);
+        break;
+      }
+
+      case mix_type::macro_batch: {
+        std::vector<virtual_hid_device_service::input_report> reports;
+        for (size_t i = 0; i < parameters.reports_per_round; ++i) {
+          reports.push_back(make_report<virtual_hid_device_driver::hid_report::keyboard_input>(make_tag(client_index, first_sequence + i)));
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        std::fill_n(std::begin(sent_times) + first_sequence, parameters.reports_per_round, now);
+        c.async_post_reports(reports);
+        break;
+      }
+    }
+  }
+
+  // This method is executed in the report strand of each client.
+  void on_recorded(const loopback_report_sink::record& record) {
+    auto state = run_state_.load();
+    uint32_t tag = 0;
+    if (!state ||
+        record.report.size() < sizeof(tag)) {
+      return;
+    }
+
+    std::memcpy(&tag, record.report.data() + record.report.size() - sizeof(tag), sizeof(tag));
+
+    auto client_index = tag >> 24;
+    auto sequence = tag & 0xffffff;
+    if (client_index < state->latencies.size() &&
+        sequence < state->latencies[client_index].size()) {
+      state->latencies[client_index][sequence] = record.recorded_time - state->sent_times[client_index][sequence];
+      ++state->delivered_count;
+    }
+  }
+
+  pqrs::not_null_shared_ptr_t<loopback_report_sink> report_sink_;
+  std::atomic<run_state*> run_state_;
+  std::unique_ptr<virtual_hid_device_service_server> server_;
+  std::vector<std::unique_ptr<peer>> peers_;
+};
+} // namespace e2e_latency_benchmark
+
+// Run the mixes and client counts which match `mix_name` and `client_count`. (All of them if they are not specified.)
+// p99 is gated against `baseline_file_path` if it has the entry, or the budget of the mix otherwise.
+// The measured p99 are written into `write_baseline_file_path` instead of being gated if it is specified.
+void run_e2e_latency_benchmark(std::optional<std::string_view> mix_name,
+                               std::optional<size_t> client_count,
+                               std::optional<std::filesystem::path> baseline_file_path,
+                               std::optional<std::filesystem::path> write_baseline_file_path) {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+  using namespace e2e_latency_benchmark;
+
+  auto socket_file_path = std::filesystem::temp_directory_path() / "virtual_hid_device_service_e2e_latency_benchmark" / "server.sock";
+
+  baseline b;
+  if (write_baseline_file_path) {
+    b.load(*write_baseline_file_path);
+  } else if (baseline_file_path) {
+    b.load(*baseline_file_path);
+  }
+
+  for (const auto& count : client_counts) {
+    if (client_count && *client_count != count) {
+      continue;
+    }
+
+    test("e2e_latency clients:" + std::to_string(count)) = [&] {
+      session s(count, socket_file_path);
+
+      auto ready = s.wait_ready();
+      expect(ready);
+      if (!ready) {
+        return;
+      }
+
+      for (const auto& parameters : mixes) {
+        if (mix_name && *mix_name != parameters.name) {
+          continue;
+        }
+
+        s.run(parameters, parameters.warm_up_round_count);
+        auto r = s.run(parameters, parameters.round_count);
+
+        auto to_microseconds = [](auto&& duration) {
+          return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        };
+
+        auto baseline_p99 = b.find_p99(parameters.name, count);
+        auto p99_budget = get_p99_budget(parameters, write_baseline_file_path ? std::nullopt : baseline_p99);
+
+        std::cout << "e2e_latency " << parameters.name
+                  << " clients:" << count
+                  << " reports:" << r.delivered_count << "/" << r.report_count
+                  << " p50:" << to_microseconds(r.p50) << "us"
+                  << " p99:" << to_microseconds(r.p99) << "us"
+                  << " p999:" << to_microseconds(r.p999) << "us"
+                  << " " << static_cast<uint64_t>(r.reports_per_second) << " reports/sec"
+                  << " cpu:" << to_microseconds(r.cpu_time) << "us";
+        if (write_baseline_file_path) {
+          std::cout << " (baseline)";
+        } else {
+          std::cout << " p99 budget:" << to_microseconds(p99_budget) << "us"
+                    << (baseline_p99 ? " (baseline)" : " (mix)");
+        }
+        std::cout << std::endl;
+
+        expect(r.delivered_count == r.report_count);
+
+        if (write_baseline_file_path) {
+          b.set_p99(parameters.name, count, r.p99);
+        } else {
+          expect(r.p99 <= p99_budget);
+        }
+      }
+    };
+  }
+
+  if (write_baseline_file_path) {
+    test("e2e_latency write baseline") = [&] {
+      expect(b.save(*write_baseline_file_path));
+    };
+  }
+}
@@ -0,0 +1,40 @@
+#include "e2e_latency_benchmark.hpp"
+#include <cstdlib>
+
+// Usage: test [--baseline file | --write-baseline file] [mix] [client_count]
+//   e.g. test --baseline baseline.txt pointing_1khz 64
+int main(int argc, const char* argv[]) {
+  std::optional<std::filesystem::path> baseline_file_path;
+  std::optional<std::filesystem::path> write_baseline_file_path;
+  std::optional<std::string_view> mix_name;
+  std::optional<size_t> client_count;
+
+  int i = 1;
+  for (; i + 1 < argc; i += 2) {
+    std::string_view option = argv[i];
+    if (option == "--baseline") {
+      baseline_file_path = argv[i + 1];
+    } else if (option == "--write-baseline") {
+      write_baseline_file_path = argv[i + 1];
+    } else {
+      break;
+    }
+  }
+
+  if (argc > i) {
+    mix_name = argv[i];
+  }
+  if (argc > i + 1) {
+    client_count = std::strtoull(argv[i + 1], nullptr, 10);
+  }
+
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  run_e2e_latency_benchmark(mix_name,
+                            client_count,
+                            baseline_file_path,
+                            write_baseline_file_path);
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  return 0;
+}
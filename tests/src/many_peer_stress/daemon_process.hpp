@@ -0,0 +1,221 @@
+#include "loopback_driver_backend.hpp"
+#include "virtual_hid_device_service_server.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sys/wait.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+namespace many_peer_stress {
+struct daemon_sample final {
+  uint64_t resident_size;
+  uint64_t thread_count;
+  // The maximum `dispatcher::queue_depth` since the previous sample.
+  uint64_t max_queue_depth;
+};
+
+inline uint64_t get_resident_size() {
+#ifdef __APPLE__
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(),
+                MACH_TASK_BASIC_INFO,
+                reinterpret_cast<task_info_t>(&info),
+                &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return info.resident_size;
+#else
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  statm >> size >> resident;
+  return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+inline uint64_t get_thread_count() {
+#ifdef __APPLE__
+  thread_act_array_t threads;
+  mach_msg_type_number_t count = 0;
+  if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  for (mach_msg_type_number_t i = 0; i < count; ++i) {
+    mach_port_deallocate(mach_task_self(), threads[i]);
+  }
+  vm_deallocate(mach_task_self(),
+                reinterpret_cast<vm_address_t>(threads),
+                count * sizeof(thread_act_t));
+  return count;
+#else
+  std::error_code error_code;
+  return std::ranges::distance(std::filesystem::directory_iterator("/proc/self/task", error_code),
+                               std::filesystem::directory_iterator());
+#endif
+}
+
+// `daemon_process` runs `virtual_hid_device_service_server` with `loopback_driver_backend` in a child process,
+// so that the resident size and threads of the daemon are measured apart from the clients.
+class daemon_process final {
+public:
+  daemon_process(const daemon_process&) = delete;
+
+  // This constructor has to be called before any thread is created in this process.
+  explicit daemon_process(const std::filesystem::path& socket_file_path) {
+    int command_pipe[2];
+    int sample_pipe[2];
+    if (pipe(command_pipe) != 0 ||
+        pipe(sample_pipe) != 0) {
+      throw std::system_error(errno, std::generic_category(), "pipe");
+    }
+
+    pid_ = fork();
+    if (pid_ == -1) {
+      throw std::system_error(errno, std::generic_category(), "fork");
+    }
+
+    if (pid_ == 0) {
+      close(command_pipe[1]);
+      close(sample_pipe[0]);
+
+      run(socket_file_path,
+          command_pipe[0],
+          sample_pipe[1]);
+
+      _exit(0);
+    }
+
+    close(command_pipe[0]);
+    close(sample_pipe[1]);
+
+    command_fd_ = command_pipe[1];
+    sample_fd_ = sample_pipe[0];
+  }
+
+  ~daemon_process() {
+    auto c = command::quit;
+    write_all(command_fd_, &c, sizeof(c));
+
+    waitpid(pid_, nullptr, 0);
+
+    close(command_fd_);
+    close(sample_fd_);
+  }
+
+  std::optional<daemon_sample> sample() const {
+    auto c = command::sample;
+    daemon_sample s;
+    if (!write_all(command_fd_, &c, sizeof(c)) ||
+        !read_all(sample_fd_, &s, sizeof(s))) {
+      return std::nullopt;
+    }
+    return s;
+  }
+
+private:
+  enum class command : uint8_t {
+    sample,
+    quit,
+  };
+
+  static bool write_all(int fd,
+                        const void* data,
+                        size_t size) {
+    auto p = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+      auto n = write(fd, p, size);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;
+      }
+      p += n;
+      size -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  static bool read_all(int fd,
+                       void* data,
+                       size_t size) {
+    auto p = static_cast<uint8_t*>(data);
+    while (size > 0) {
+      auto n = read(fd, p, size);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        return false;
+      }
+      p += n;
+      size -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  // This method is executed in the child process.
+  static void run(const std::filesystem::path& socket_file_path,
+                  int command_fd,
+                  int sample_fd) {
+    pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+    {
+      auto dispatcher = pqrs::dispatcher::extra::get_shared_dispatcher();
+
+      // `queue_depth` is sampled every millisecond in `sampler` since it changes too fast to be sampled on demand.
+      std::atomic<bool> exit = false;
+      std::atomic<size_t> max_queue_depth = 0;
+      std::thread sampler([&] {
+        while (!exit) {
+          auto depth = dispatcher->queue_depth();
+          auto max = max_queue_depth.load();
+          while (max < depth &&
+                 !max_queue_depth.compare_exchange_weak(max, depth)) {
+          }
+
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      });
+
+      {
+        auto server = std::make_unique<virtual_hid_device_service_server>(
+            std::make_shared<loopback_driver_backend>(std::make_shared<loopback_report_sink>(0)),
+            socket_file_path);
+
+        command c;
+        while (read_all(command_fd, &c, sizeof(c)) &&
+               c == command::sample) {
+          daemon_sample s{
+              .resident_size = get_resident_size(),
+              // Exclude `sampler`.
+              .thread_count = get_thread_count() - 1,
+              .max_queue_depth = max_queue_depth.exchange(0),
+          };
+          write_all(sample_fd, &s, sizeof(s));
+        }
+      }
+
+      exit = true;
+      sampler.join();
+    }
+
+    pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  }
+
+  pid_t pid_;
+  int command_fd_;
+  int sample_fd_;
+};
+} // namespace many_peer_stress
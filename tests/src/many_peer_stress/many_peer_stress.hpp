@@ -0,0 +1,336 @@
+#include "daemon_process.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <climits>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+namespace many_peer_stress {
+// Each client connects to the daemon, initializes the keyboard and pointing devices,
+// and posts a pointing report every `report_interval` for `round_count` rounds.
+constexpr std::array<size_t, 4> client_counts{1, 8, 64, 512};
+constexpr size_t round_count = 100;
+
+constexpr auto timeout = std::chrono::seconds(30);
+
+struct options final {
+  size_t max_client_count = client_counts.back();
+  std::chrono::milliseconds report_interval = std::chrono::milliseconds(10);
+};
+
+class peer final {
+public:
+  peer(const peer&) = delete;
+
+  explicit peer(const std::filesystem::path& socket_file_path)
+      : virtual_hid_keyboard_ready_(false),
+        virtual_hid_pointing_ready_(false),
+        statistics_count_(0) {
+    client_ = std::make_unique<pqrs::karabiner::driverkit::virtual_hid_device_service::client>(
+        pqrs::karabiner::driverkit::virtual_hid_device_service::client_options{
+            .server_socket_file_path = socket_file_path,
+        });
+
+    client_->connected.connect([this] {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!accept_latency_) {
+          accept_latency_ = std::chrono::steady_clock::now() - start_time_;
+        }
+      }
+
+      client_->async_virtual_hid_keyboard_initialize(pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters());
+      client_->async_virtual_hid_pointing_initialize();
+    });
+    client_->virtual_hid_keyboard_ready.connect([this](auto&& ready) {
+      virtual_hid_keyboard_ready_ = ready;
+    });
+    client_->virtual_hid_pointing_ready.connect([this](auto&& ready) {
+      virtual_hid_pointing_ready_ = ready;
+    });
+    client_->statistics_received.connect([this](auto&& statistics) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        statistics_ = statistics;
+      }
+
+      ++statistics_count_;
+    });
+  }
+
+  void async_start() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      start_time_ = std::chrono::steady_clock::now();
+    }
+
+    client_->async_start();
+  }
+
+  bool ready() const {
+    return virtual_hid_keyboard_ready_ && virtual_hid_pointing_ready_;
+  }
+
+  // The time from `async_start` to `connected`.
+  std::optional<std::chrono::nanoseconds> get_accept_latency() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return accept_latency_;
+  }
+
+  void async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input& report) {
+    client_->async_post_report(report);
+  }
+
+  void async_get_statistics() {
+    client_->async_get_statistics();
+  }
+
+  uint64_t get_statistics_count() const {
+    return statistics_count_;
+  }
+
+  pqrs::karabiner::driverkit::virtual_hid_device_service::statistics get_statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return statistics_;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::optional<std::chrono::nanoseconds> accept_latency_;
+  pqrs::karabiner::driverkit::virtual_hid_device_service::statistics statistics_{};
+
+  std::atomic<bool> virtual_hid_keyboard_ready_;
+  std::atomic<bool> virtual_hid_pointing_ready_;
+  std::atomic<uint64_t> statistics_count_;
+
+  // `client_` is destroyed first since its signals refer the above members.
+  std::unique_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client> client_;
+};
+
+template <typename T>
+T percentile(std::vector<T> values,
+             double p) {
+  if (values.empty()) {
+    return T{};
+  }
+
+  std::ranges::sort(values);
+  auto index = static_cast<size_t>(static_cast<double>(values.size()) * p);
+  return values[std::min(index, values.size() - 1)];
+}
+
+template <typename Predicate>
+bool wait_until(Predicate predicate) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!predicate()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// Each client in this process uses a socket and the descriptors of its own io_context,
+// and the daemon (which inherits the limit at fork) uses a socket per peer.
+constexpr rlim_t file_descriptors_per_client = 4;
+constexpr rlim_t reserved_file_descriptors = 64;
+
+// Raise the soft limit of open files (256 by default on macOS) so that `max_client_count` clients can connect.
+// Returns the number of clients which the limit allows.
+inline size_t raise_open_file_limit(size_t max_client_count) {
+  auto required = static_cast<rlim_t>(max_client_count) * file_descriptors_per_client + reserved_file_descriptors;
+
+  rlimit limit{};
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+    return max_client_count;
+  }
+
+  if (limit.rlim_cur < required) {
+    auto hard_limit = limit.rlim_max;
+#ifdef __APPLE__
+    // setrlimit fails with a soft limit above OPEN_MAX even if the hard limit is RLIM_INFINITY.
+    hard_limit = std::min(hard_limit, static_cast<rlim_t>(OPEN_MAX));
+#endif
+
+    limit.rlim_cur = std::min(required, hard_limit);
+    if (setrlimit(RLIMIT_NOFILE, &limit) != 0 ||
+        getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+      return max_client_count;
+    }
+  }
+
+  if (limit.rlim_cur < required) {
+    return static_cast<size_t>((limit.rlim_cur - std::min(limit.rlim_cur, reserved_file_descriptors)) / file_descriptors_per_client);
+  }
+
+  return max_client_count;
+}
+
+inline uint64_t to_microseconds(std::chrono::nanoseconds duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+inline int64_t to_kibibytes(int64_t bytes) {
+  return bytes / 1024;
+}
+} // namespace many_peer_stress
+
+void run_many_peer_stress(const many_peer_stress::daemon_process& daemon,
+                          const std::filesystem::path& socket_file_path,
+                          const many_peer_stress::options& options) {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+  using namespace many_peer_stress;
+
+  for (const auto& client_count : client_counts) {
+    if (client_count > options.max_client_count) {
+      continue;
+    }
+
+    test("many_peer_stress clients:" + std::to_string(client_count)) = [&] {
+      auto baseline = daemon.sample();
+      expect(baseline != std::nullopt);
+      if (!baseline) {
+        return;
+      }
+
+      std::vector<std::unique_ptr<peer>> peers;
+      for (size_t i = 0; i < client_count; ++i) {
+        peers.push_back(std::make_unique<peer>(socket_file_path));
+      }
+
+      //
+      // Connect
+      //
+
+      for (auto&& p : peers) {
+        p->async_start();
+      }
+
+      auto ready = wait_until([&] {
+        return std::ranges::all_of(peers, [](auto&& p) {
+          return p->ready();
+        });
+      });
+      expect(ready);
+      if (!ready) {
+        return;
+      }
+
+      std::vector<std::chrono::nanoseconds> accept_latencies;
+      for (const auto& p : peers) {
+        if (auto l = p->get_accept_latency()) {
+          accept_latencies.push_back(*l);
+        }
+      }
+
+      auto connected = daemon.sample();
+
+      //
+      // Post reports
+      //
+
+      auto start = std::chrono::steady_clock::now();
+      for (size_t round = 0; round < round_count; ++round) {
+        std::this_thread::sleep_until(start + round * options.report_interval);
+
+        pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input report;
+        report.x = static_cast<uint8_t>(round);
+
+        for (auto&& p : peers) {
+          p->async_post_report(report);
+        }
+      }
+
+      auto forwarded = wait_until([&] {
+        std::vector<uint64_t> statistics_counts;
+        for (auto&& p : peers) {
+          statistics_counts.push_back(p->get_statistics_count());
+          p->async_get_statistics();
+        }
+
+        if (!wait_until([&] {
+              for (size_t i = 0; i < peers.size(); ++i) {
+                if (peers[i]->get_statistics_count() == statistics_counts[i]) {
+                  return false;
+                }
+              }
+              return true;
+            })) {
+          return false;
+        }
+
+        return std::ranges::all_of(peers, [](auto&& p) {
+          return p->get_statistics().forwarded_reports == round_count;
+        });
+      });
+      expect(forwarded);
+
+      auto posted = daemon.sample();
+
+      std::vector<uint64_t> p99_forward_latencies;
+      std::vector<uint64_t> mean_forward_latencies;
+      for (const auto& p : peers) {
+        auto statistics = p->get_statistics();
+        p99_forward_latencies.push_back(statistics.p99_forward_latency);
+        mean_forward_latencies.push_back(statistics.mean_forward_latency);
+      }
+
+      //
+      // Print
+      //
+
+      expect(accept_latencies.size() == client_count);
+      expect(connected != std::nullopt);
+      expect(posted != std::nullopt);
+      if (!connected || !posted) {
+        return;
+      }
+
+      auto resident_size_per_peer = (static_cast<int64_t>(connected->resident_size) - static_cast<int64_t>(baseline->resident_size)) /
+                                    static_cast<int64_t>(client_count);
+      auto threads_per_peer = (static_cast<double>(connected->thread_count) - static_cast<double>(baseline->thread_count)) /
+                              static_cast<double>(client_count);
+
+      std::cout << "many_peer_stress clients:" << client_count << std::endl
+                << "  accept latency: p50:" << to_microseconds(percentile(accept_latencies, 0.5)) << "us"
+                << " p99:" << to_microseconds(percentile(accept_latencies, 0.99)) << "us"
+                << " max:" << to_microseconds(percentile(accept_latencies, 1.0)) << "us" << std::endl
+                << "  daemon rss: " << to_kibibytes(connected->resident_size) << " KiB"
+                << " (" << to_kibibytes(resident_size_per_peer) << " KiB/peer)"
+                << " after posting: " << to_kibibytes(posted->resident_size) << " KiB" << std::endl
+                << "  daemon threads: " << connected->thread_count
+                << " (" << threads_per_peer << "/peer)" << std::endl
+                << "  dispatcher queue depth: max:" << std::max(connected->max_queue_depth, posted->max_queue_depth) << std::endl
+                << "  forward latency per peer: mean p50:" << percentile(mean_forward_latencies, 0.5) / 1000 << "us"
+                << " p99 p50:" << percentile(p99_forward_latencies, 0.5) / 1000 << "us"
+                << " p99 max:" << percentile(p99_forward_latencies, 1.0) / 1000 << "us" << std::endl;
+
+      //
+      // Disconnect
+      //
+
+      peers.clear();
+
+      // Wait until the daemon closes the peers.
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    };
+  }
+}
@@ -0,0 +1,40 @@
+#include "many_peer_stress.hpp"
+#include <cstdlib>
+#include <iostream>
+
+// Usage: test [max_client_count] [report_interval_milliseconds]
+//   e.g. test 64 1
+int main(int argc, const char* argv[]) {
+  many_peer_stress::options options;
+
+  if (argc > 1) {
+    options.max_client_count = std::strtoull(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    options.report_interval = std::chrono::milliseconds(std::strtoull(argv[2], nullptr, 10));
+  }
+
+  // Raise the limit before the daemon process inherits it.
+  auto client_count_limit = many_peer_stress::raise_open_file_limit(options.max_client_count);
+  if (client_count_limit < options.max_client_count) {
+    std::cerr << "The open files limit allows only " << client_count_limit << " clients." << std::endl;
+    options.max_client_count = client_count_limit;
+  }
+
+  auto socket_file_path = std::filesystem::temp_directory_path() / "virtual_hid_device_service_many_peer_stress" / "server.sock";
+
+  // Start the daemon process before the dispatcher thread of this process is created.
+  many_peer_stress::daemon_process daemon(socket_file_path);
+
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  // Wait until the daemon binds the socket.
+  many_peer_stress::wait_until([&] {
+    return std::filesystem::exists(socket_file_path);
+  });
+
+  run_many_peer_stress(daemon, socket_file_path, options);
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <pqrs/unix_domain_stream.hpp>
+#include <thread>
+#include <vector>
+
+namespace client_test {
+inline bool wait(const std::atomic<size_t>& value, size_t expected) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (value < expected) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+} // namespace client_test
+
+void run_client_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+  using namespace client_test;
+
+  "client with released packages"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    auto socket_file_path = std::filesystem::temp_directory_path() / "virtual_hid_device_service_released_packages_test.sock";
+
+    auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+    auto server_dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+    std::atomic<size_t> connected_count = 0;
+    std::atomic<size_t> received_count = 0;
+    std::mutex received_mutex;
+    std::vector<std::vector<uint8_t>> received_buffers;
+
+    // `coalesce_reports` has no effect with the released pqrs::unix_domain_stream.
+    client_options options;
+    options.server_socket_file_path = socket_file_path;
+    options.coalesce_reports = true;
+    auto c = std::make_unique<client>(options);
+    c->connected.connect([&] {
+      ++connected_count;
+    });
+
+    auto server = std::make_unique<pqrs::unix_domain_stream::server>(server_dispatcher,
+                                                                      socket_file_path);
+    server->received.connect([&](auto&&, auto&& buffer) {
+      {
+        std::lock_guard<std::mutex> lock(received_mutex);
+        received_buffers.push_back(*buffer);
+      }
+      ++received_count;
+    });
+    server->bound.connect([&] {
+      c->async_start();
+    });
+    server->async_start();
+
+    expect(wait(connected_count, 1));
+
+    virtual_hid_device_driver::hid_report::keyboard_input keyboard_input;
+    keyboard_input.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+
+    virtual_hid_device_driver::hid_report::pointing_input pointing_input;
+    pointing_input.x = 10;
+
+    c->async_post_report(keyboard_input);
+    c->async_post_report(pointing_input);
+
+    expect(wait(received_count, 2));
+
+    {
+      std::lock_guard<std::mutex> lock(received_mutex);
+
+      auto keyboard_buffer = make_request_buffer(request::post_keyboard_input_report, keyboard_input);
+      auto pointing_buffer = make_request_buffer(request::post_pointing_input_report, pointing_input);
+
+      expect(fatal(received_buffers.size() == 2_ul));
+      expect(std::ranges::equal(received_buffers[0], keyboard_buffer));
+      expect(std::ranges::equal(received_buffers[1], pointing_buffer));
+    }
+
+    c = nullptr;
+    server = nullptr;
+    server_dispatcher->terminate();
+  };
+}
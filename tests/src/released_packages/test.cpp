@@ -0,0 +1,10 @@
+#include "client_test.hpp"
+
+int main() {
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  run_client_test();
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  return 0;
+}
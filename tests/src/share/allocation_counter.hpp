@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts global heap allocations in order to verify allocation-free code paths.
+// This header replaces the global `operator new`, so include it from only one translation unit.
+//
+// asio allocates handlers with `std::aligned_alloc` unless `ASIO_DISABLE_STD_ALIGNED_ALLOC` is defined.
+// Tests which count the allocations of asio handlers define it in CMakeLists.txt.
+
+namespace allocation_counter {
+inline std::atomic<bool> counting = false;
+inline std::atomic<bool> marked_threads_only = false;
+inline std::atomic<size_t> count = 0;
+inline thread_local bool marked_thread = false;
+
+// Returns the number of heap allocations in this process while `function` is running.
+inline size_t count_allocations(auto&& function) {
+  count = 0;
+  counting = true;
+  function();
+  counting = false;
+  return count;
+}
+
+// Returns the number of heap allocations in the threads which set `marked_thread` while `function` is running.
+// Use this to exclude threads which are out of the measured path, e.g., io threads of a test server.
+inline size_t count_marked_thread_allocations(auto&& function) {
+  marked_threads_only = true;
+  auto result = count_allocations(function);
+  marked_threads_only = false;
+  return result;
+}
+} // namespace allocation_counter
+
+// The replacements are not inlined, since GCC reports `-Wmismatched-new-delete`
+// when it sees `std::free` of a pointer returned by an inlined `operator new`.
+
+[[gnu::noinline]] void* operator new(std::size_t size) {
+  if (allocation_counter::counting &&
+      (!allocation_counter::marked_threads_only || allocation_counter::marked_thread)) {
+    ++allocation_counter::count;
+  }
+
+  if (auto p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <pqrs/dispatcher.hpp>
+
+// Run functions in the dispatcher thread of the shared dispatcher, and wait until they are finished.
+class dispatcher_runner final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  ~dispatcher_runner() override {
+    detach_from_dispatcher();
+  }
+
+  void run(std::function<void()> function) {
+    std::promise<void> promise;
+    enqueue_to_dispatcher([&] {
+      function();
+      promise.set_value();
+    });
+    promise.get_future().wait();
+  }
+};
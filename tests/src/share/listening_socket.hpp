@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstring>
+#include <filesystem>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Bind and listen as a service manager does for socket activation.
+// Returns -1 on failure.
+inline int make_listening_socket(const std::filesystem::path& socket_file_path) {
+  std::error_code error_code;
+  std::filesystem::create_directories(socket_file_path.parent_path(), error_code);
+  std::filesystem::remove(socket_file_path, error_code);
+
+  auto s = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socket_file_path.c_str(), sizeof(address.sun_path) - 1);
+
+  if (bind(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(s, SOMAXCONN) != 0) {
+    close(s);
+    return -1;
+  }
+
+  return s;
+}
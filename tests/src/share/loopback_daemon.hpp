@@ -0,0 +1,156 @@
+#pragma once
+
+#include "listening_socket.hpp"
+#include "loopback_driver_backend.hpp"
+#include "virtual_hid_device_service_server.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <string>
+#include <thread>
+
+// Wait until `function` returns true.
+// Returns false if `timeout` elapses.
+template <typename F>
+bool wait_until(F&& function,
+                std::chrono::milliseconds timeout = std::chrono::milliseconds(10000)) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!function()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return true;
+}
+
+struct loopback_daemon_options final {
+  // Accept connections on a socket which is bound before the server starts, as with socket activation.
+  bool listening_socket = false;
+  // The number of records which the report sink keeps.
+  size_t report_sink_capacity = 65536;
+};
+
+// Run `virtual_hid_device_service_server` with `loopback_driver_backend` on a socket in a temporary directory.
+class loopback_daemon final {
+public:
+  loopback_daemon(const loopback_daemon&) = delete;
+
+  // The socket is created in `virtual_hid_device_service_<name>` in the temporary directory.
+  explicit loopback_daemon(const std::string& name,
+                           const loopback_daemon_options& options = {})
+      : socket_file_path_(std::filesystem::temp_directory_path() / ("virtual_hid_device_service_" + name) / "server.sock"),
+        report_sink_(std::make_shared<loopback_report_sink>(options.report_sink_capacity)),
+        backend_(std::make_shared<loopback_driver_backend>(report_sink_)) {
+    if (options.listening_socket) {
+      listening_socket_ = make_listening_socket(socket_file_path_);
+    }
+  }
+
+  ~loopback_daemon() {
+    stop_server();
+
+    std::error_code error_code;
+    std::filesystem::remove_all(socket_file_path_.parent_path(), error_code);
+  }
+
+  const std::filesystem::path& get_socket_file_path() const {
+    return socket_file_path_;
+  }
+
+  // Returns std::nullopt without `loopback_daemon_options::listening_socket`, or -1 if binding the listening socket failed.
+  std::optional<int> get_listening_socket() const {
+    return listening_socket_;
+  }
+
+  pqrs::not_null_shared_ptr_t<loopback_report_sink> get_report_sink() const {
+    return report_sink_;
+  }
+
+  pqrs::not_null_shared_ptr_t<loopback_driver_backend> get_backend() const {
+    return backend_;
+  }
+
+  void start_server() {
+    server_ = std::make_unique<virtual_hid_device_service_server>(backend_,
+                                                                  socket_file_path_,
+                                                                  listening_socket_);
+  }
+
+  void stop_server() {
+    server_ = nullptr;
+  }
+
+private:
+  std::filesystem::path socket_file_path_;
+  std::optional<int> listening_socket_;
+  pqrs::not_null_shared_ptr_t<loopback_report_sink> report_sink_;
+  pqrs::not_null_shared_ptr_t<loopback_driver_backend> backend_;
+  std::unique_ptr<virtual_hid_device_service_server> server_;
+};
+
+// The virtual HID devices which `loopback_daemon_client` initializes.
+struct loopback_daemon_client_devices final {
+  bool keyboard = true;
+  bool pointing = true;
+};
+
+// A client of `loopback_daemon` which initializes the virtual HID devices when it is connected.
+class loopback_daemon_client final {
+public:
+  loopback_daemon_client(const loopback_daemon_client&) = delete;
+
+  // `options.server_socket_file_path` is replaced with the socket of `daemon`.
+  loopback_daemon_client(const loopback_daemon& daemon,
+                         pqrs::karabiner::driverkit::virtual_hid_device_service::client_options options = {},
+                         const loopback_daemon_client_devices& initialized_devices = {})
+      : devices_(initialized_devices),
+        keyboard_ready_(false),
+        pointing_ready_(false) {
+    options.server_socket_file_path = daemon.get_socket_file_path();
+    client_ = std::make_unique<pqrs::karabiner::driverkit::virtual_hid_device_service::client>(options);
+
+    client_->connected.connect([this] {
+      if (devices_.keyboard) {
+        client_->async_virtual_hid_keyboard_initialize(pqrs::karabiner::driverkit::virtual_hid_device_service::virtual_hid_keyboard_parameters());
+      }
+      if (devices_.pointing) {
+        client_->async_virtual_hid_pointing_initialize();
+      }
+    });
+    client_->virtual_hid_keyboard_ready.connect([this](auto&& value) {
+      keyboard_ready_ = value;
+    });
+    client_->virtual_hid_pointing_ready.connect([this](auto&& value) {
+      pointing_ready_ = value;
+    });
+  }
+
+  // Connect signals of the client before `async_start`.
+  pqrs::karabiner::driverkit::virtual_hid_device_service::client& get() const {
+    return *client_;
+  }
+
+  void async_start() const {
+    client_->async_start();
+  }
+
+  // Wait until the initialized devices are ready.
+  bool wait_ready(std::chrono::milliseconds timeout = std::chrono::milliseconds(10000)) const {
+    return wait_until(
+        [this] {
+          return (!devices_.keyboard || keyboard_ready_) &&
+                 (!devices_.pointing || pointing_ready_);
+        },
+        timeout);
+  }
+
+private:
+  loopback_daemon_client_devices devices_;
+  std::atomic<bool> keyboard_ready_;
+  std::atomic<bool> pointing_ready_;
+  std::unique_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::client> client_;
+};
@@ -0,0 +1,130 @@
+#include <boost/ut.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <pqrs/unix_domain_stream.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace listening_socket_test {
+// Bind and listen as a service manager does for socket activation.
+inline int make_listening_socket(const std::filesystem::path& socket_file_path) {
+  std::error_code error_code;
+  std::filesystem::remove(socket_file_path, error_code);
+
+  auto s = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, socket_file_path.c_str(), sizeof(address.sun_path) - 1);
+
+  if (bind(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(s, SOMAXCONN) != 0) {
+    close(s);
+    return -1;
+  }
+
+  return s;
+}
+
+class counter final {
+public:
+  void increment() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++count_;
+    }
+    cv_.notify_all();
+  }
+
+  bool wait(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(5), [this, count] {
+      return count_ >= count;
+    });
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t count_ = 0;
+};
+} // namespace listening_socket_test
+
+void run_listening_socket_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+  using namespace listening_socket_test;
+
+  "listening_socket"_test = [] {
+    auto socket_file_path = std::filesystem::temp_directory_path() / "unix_domain_stream_listening_socket_test.sock";
+
+    auto listening_socket = make_listening_socket(socket_file_path);
+    expect(listening_socket != -1_i);
+    if (listening_socket == -1) {
+      return;
+    }
+
+    counter connected;
+    counter received;
+    counter bound;
+
+    //
+    // Clients can connect and send before the server is started, since the socket is already listening.
+    //
+
+    auto client = std::make_unique<pqrs::unix_domain_stream::client>(pqrs::dispatcher::extra::get_shared_dispatcher(),
+                                                                     socket_file_path);
+    client->connected.connect([&](auto&&) {
+      connected.increment();
+    });
+    client->async_start();
+
+    expect(connected.wait(1));
+
+    client->async_send(std::vector<uint8_t>{1, 2, 3});
+
+    auto server = std::make_unique<pqrs::unix_domain_stream::server>(pqrs::dispatcher::extra::get_shared_dispatcher(),
+                                                                     socket_file_path);
+    server->bound.connect([&] {
+      bound.increment();
+    });
+    server->received.connect([&](auto&&, auto&& buffer) {
+      if (*buffer == std::vector<uint8_t>{1, 2, 3}) {
+        received.increment();
+      }
+    });
+    server->async_start(listening_socket);
+
+    expect(bound.wait(1));
+    expect(received.wait(1));
+
+    //
+    // The server accepts connections on the same socket after restart.
+    //
+
+    server->async_stop();
+    server->async_start();
+
+    expect(bound.wait(2));
+    expect(connected.wait(2));
+
+    client->async_send(std::vector<uint8_t>{1, 2, 3});
+    expect(received.wait(2));
+
+    //
+    // The socket file is not removed since it belongs to the service manager.
+    //
+
+    client = nullptr;
+    server = nullptr;
+
+    expect(std::filesystem::exists(socket_file_path));
+
+    std::error_code error_code;
+    std::filesystem::remove(socket_file_path, error_code);
+  };
+}
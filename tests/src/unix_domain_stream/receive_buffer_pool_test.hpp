@@ -0,0 +1,77 @@
+#include <boost/ut.hpp>
+#include <pqrs/unix_domain_stream.hpp>
+
+void run_receive_buffer_pool_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "receive_buffer_pool"_test = [] {
+    pqrs::unix_domain_stream::impl::receive_buffer_pool pool(1024);
+
+    auto buffer1 = pool.acquire(100);
+    expect(buffer1->size() == 100_ul);
+    expect(pool.size() == 1_ul);
+
+    // buffer1 is still used.
+    auto buffer2 = pool.acquire(10);
+    expect(buffer2->size() == 10_ul);
+    expect(pool.size() == 2_ul);
+
+    // Released buffers are reused.
+    auto p = buffer1.get().get();
+    buffer1 = buffer2;
+    auto buffer3 = pool.acquire(50);
+    expect(buffer3.get().get() == p);
+    expect(buffer3->size() == 50_ul);
+    expect(pool.size() == 2_ul);
+  };
+
+  "receive_buffer_pool max_size"_test = [] {
+    pqrs::unix_domain_stream::impl::receive_buffer_pool pool(128);
+
+    {
+      auto buffer1 = pool.acquire(100);
+      auto buffer2 = pool.acquire(100);
+      expect(pool.size() == 1_ul);
+      expect(pool.pooled_size() <= 128_ul);
+    }
+
+    // The reused buffer grows beyond the limit and is removed from the pool.
+    {
+      auto buffer = pool.acquire(200);
+      expect(buffer->size() == 200_ul);
+      expect(pool.size() == 0_ul);
+      expect(pool.pooled_size() == 0_ul);
+    }
+
+    // Pooling is disabled.
+    {
+      pqrs::unix_domain_stream::impl::receive_buffer_pool disabled_pool(0);
+      auto buffer1 = disabled_pool.acquire(10);
+      expect(buffer1->size() == 10_ul);
+      auto buffer2 = disabled_pool.acquire(0);
+      expect(buffer2->size() == 0_ul);
+      expect(disabled_pool.size() == 0_ul);
+    }
+  };
+
+  "receive_buffer_pool max_buffer_count"_test = [] {
+    using receive_buffer_pool = pqrs::unix_domain_stream::impl::receive_buffer_pool;
+
+    receive_buffer_pool pool(1024 * 1024);
+
+    // Empty payloads have no capacity, but they are also limited.
+    std::vector<pqrs::not_null_shared_ptr_t<std::vector<uint8_t>>> buffers;
+    for (size_t i = 0; i < receive_buffer_pool::max_buffer_count + 10; ++i) {
+      buffers.push_back(pool.acquire(i % 2 == 0 ? 0 : 10));
+    }
+    expect(pool.size() == receive_buffer_pool::max_buffer_count);
+
+    // The pooled buffers are reused after they are released.
+    buffers.clear();
+    for (size_t i = 0; i < receive_buffer_pool::max_buffer_count + 10; ++i) {
+      buffers.push_back(pool.acquire(10));
+    }
+    expect(pool.size() == receive_buffer_pool::max_buffer_count);
+  };
+}
@@ -0,0 +1,194 @@
+#include <boost/ut.hpp>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <pqrs/unix_domain_stream.hpp>
+#include <thread>
+
+namespace request_manager_test {
+class runner final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  runner()
+      : dispatcher_client(pqrs::dispatcher::extra::get_shared_dispatcher()),
+        request_manager_(io_ctx_, *this),
+        work_guard_(asio::make_work_guard(io_ctx_)) {
+    io_ctx_thread_ = std::thread([this] {
+      io_ctx_.run();
+    });
+  }
+
+  ~runner() override {
+    detach_from_dispatcher();
+
+    asio::post(io_ctx_, [this] {
+      work_guard_.reset();
+    });
+
+    io_ctx_thread_.join();
+  }
+
+  // Call `f(request_manager)` in the io_context thread and wait for it.
+  template <typename F>
+  void run(F&& f) {
+    std::promise<void> promise;
+    asio::post(io_ctx_, [&] {
+      f(request_manager_);
+      promise.set_value();
+    });
+    promise.get_future().wait();
+  }
+
+  void push_result(size_t index, const asio::error_code& error_code) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      results_.emplace_back(index, error_code);
+    }
+    cv_.notify_all();
+  }
+
+  std::vector<std::pair<size_t, asio::error_code>> wait_results(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, std::chrono::seconds(5), [this, count] {
+      return results_.size() >= count;
+    });
+    return results_;
+  }
+
+private:
+  asio::io_context io_ctx_;
+  pqrs::unix_domain_stream::impl::request_manager request_manager_;
+  asio::executor_work_guard<asio::io_context::executor_type> work_guard_;
+  std::thread io_ctx_thread_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::pair<size_t, asio::error_code>> results_;
+};
+} // namespace request_manager_test
+
+void run_request_manager_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "request_manager timeout"_test = [] {
+    request_manager_test::runner r;
+
+    size_t timeout_count = 0;
+    std::vector<pqrs::unix_domain_stream::request_id> ids;
+    auto start = std::chrono::steady_clock::now();
+
+    r.run([&](auto&& m) {
+      for (auto [index, timeout] : std::vector<std::pair<size_t, int>>{
+               {0, 200},
+               {1, 50},
+               {2, 100},
+               {3, 10000},
+           }) {
+        ids.push_back(m.add(std::nullopt,
+                            std::chrono::milliseconds(timeout),
+                            [&r, index](auto&& error_code, auto&&) {
+                              r.push_result(index, error_code);
+                            },
+                            [&] {
+                              ++timeout_count;
+                            }));
+      }
+
+      m.complete(ids[2], {}, nullptr);
+    });
+
+    auto results = r.wait_results(3);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    expect(results.size() == 3_ul);
+    expect(results[0] == std::make_pair(size_t(2), asio::error_code()));
+    expect(results[1] == std::make_pair(size_t(1), asio::error_code(asio::error::timed_out)));
+    expect(results[2] == std::make_pair(size_t(0), asio::error_code(asio::error::timed_out)));
+    expect(elapsed.count() >= 200.0_d);
+
+    r.run([&](auto&& m) {
+      expect(timeout_count == 2_ul);
+      expect(m.size() == 1_ul);
+
+      m.complete_all(asio::error::operation_aborted);
+      expect(m.size() == 0_ul);
+      expect(!m.armed());
+    });
+
+    results = r.wait_results(4);
+    expect(results.size() == 4_ul);
+    expect(results[3] == std::make_pair(size_t(3), asio::error_code(asio::error::operation_aborted)));
+  };
+
+  "request_manager complete_peer"_test = [] {
+    request_manager_test::runner r;
+
+    r.run([&](auto&& m) {
+      for (size_t i = 0; i < 100; ++i) {
+        m.add(pqrs::unix_domain_stream::peer_id(i % 2),
+              std::chrono::milliseconds(10000),
+              [&r, i](auto&& error_code, auto&&) {
+                r.push_result(i, error_code);
+              });
+      }
+
+      m.complete_peer(pqrs::unix_domain_stream::peer_id(1), asio::error::connection_reset);
+      expect(m.size() == 50_ul);
+
+      // The request belongs to another peer.
+      m.complete(pqrs::unix_domain_stream::peer_id(1), 1, {}, nullptr);
+      expect(m.size() == 50_ul);
+
+      m.complete(pqrs::unix_domain_stream::peer_id(0), 1, {}, nullptr);
+      expect(m.size() == 49_ul);
+    });
+
+    auto results = r.wait_results(51);
+    expect(results.size() == 51_ul);
+    expect(results.back() == std::make_pair(size_t(0), asio::error_code()));
+
+    r.run([&](auto&& m) {
+      m.complete_all(asio::error::operation_aborted);
+    });
+
+    r.wait_results(100);
+  };
+
+  "request_manager disarm"_test = [] {
+    request_manager_test::runner r;
+
+    r.run([&](auto&& m) {
+      auto id = m.add(std::nullopt,
+                      std::chrono::milliseconds(10000),
+                      [&r](auto&& error_code, auto&&) {
+                        r.push_result(0, error_code);
+                      });
+      expect(m.armed());
+
+      // The timer is stopped when the last pending request is completed.
+      m.complete(id, {}, nullptr);
+      expect(!m.armed());
+    });
+
+    r.wait_results(1);
+
+    // The wheel is armed again for a new request.
+    r.run([&](auto&& m) {
+      m.add(std::nullopt,
+            std::chrono::milliseconds(50),
+            [&r](auto&& error_code, auto&&) {
+              r.push_result(1, error_code);
+            });
+      expect(m.armed());
+    });
+
+    auto results = r.wait_results(2);
+    expect(results.size() == 2_ul);
+    expect(results.back() == std::make_pair(size_t(1), asio::error_code(asio::error::timed_out)));
+
+    r.run([&](auto&& m) {
+      expect(m.size() == 0_ul);
+      expect(!m.armed());
+    });
+  };
+}
@@ -0,0 +1,58 @@
+#include <boost/ut.hpp>
+#include <pqrs/unix_domain_stream.hpp>
+
+void run_send_buffer_pool_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "send_buffer_pool"_test = [] {
+    pqrs::unix_domain_stream::impl::send_buffer_pool pool(1024);
+
+    auto buffer1 = pool.acquire(100);
+    expect(buffer1.size() == 100_ul);
+    expect(pool.size() == 0_ul);
+
+    // Released buffers are reused.
+    auto p = buffer1.data();
+    pool.release(std::move(buffer1));
+    expect(pool.size() == 1_ul);
+
+    auto buffer2 = pool.acquire(50);
+    expect(buffer2.data() == p);
+    expect(buffer2.size() == 50_ul);
+    expect(pool.size() == 0_ul);
+    expect(pool.pooled_size() == 0_ul);
+
+    // A buffer which is large enough is preferred.
+    auto buffer3 = pool.acquire(10);
+    buffer3.shrink_to_fit();
+    pool.release(std::move(buffer2));
+    pool.release(std::move(buffer3));
+    expect(pool.size() == 2_ul);
+
+    auto buffer4 = pool.acquire(80);
+    expect(buffer4.data() == p);
+    expect(pool.size() == 1_ul);
+  };
+
+  "send_buffer_pool max_size"_test = [] {
+    pqrs::unix_domain_stream::impl::send_buffer_pool pool(128);
+
+    pool.release(std::vector<uint8_t>(100));
+    pool.release(std::vector<uint8_t>(100));
+    expect(pool.size() == 1_ul);
+    expect(pool.pooled_size() <= 128_ul);
+
+    // Empty buffers are not pooled.
+    pool.release(std::vector<uint8_t>());
+    expect(pool.size() == 1_ul);
+
+    // Pooling is disabled.
+    {
+      pqrs::unix_domain_stream::impl::send_buffer_pool disabled_pool(0);
+      disabled_pool.release(std::vector<uint8_t>(10));
+      expect(disabled_pool.size() == 0_ul);
+      expect(disabled_pool.acquire(10).size() == 10_ul);
+    }
+  };
+}
@@ -0,0 +1,16 @@
+#include "listening_socket_test.hpp"
+#include "receive_buffer_pool_test.hpp"
+#include "request_manager_test.hpp"
+#include "send_buffer_pool_test.hpp"
+
+int main() {
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  run_listening_socket_test();
+  run_receive_buffer_pool_test();
+  run_request_manager_test();
+  run_send_buffer_pool_test();
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include "allocation_counter.hpp"
+#include "dispatcher_runner.hpp"
+#include <atomic>
+#include <boost/ut.hpp>
+#include <chrono>
+#include <filesystem>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <pqrs/unix_domain_stream.hpp>
+#include <thread>
+
+namespace client_allocation_test {
+inline bool wait(const std::atomic<size_t>& value, size_t expected) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (value < expected) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+} // namespace client_allocation_test
+
+void run_client_allocation_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+  using namespace client_allocation_test;
+
+  "client post report path does not allocate"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+
+    constexpr size_t warm_up_count = 1000;
+    constexpr size_t report_count = 1000;
+
+    auto socket_file_path = std::filesystem::temp_directory_path() / "virtual_hid_device_service_client_allocation_test.sock";
+
+    // The server runs on its own dispatcher, so its work is not mixed into the client's dispatcher thread.
+    auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+    auto server_dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+    std::atomic<size_t> connected_count = 0;
+    std::atomic<size_t> received_count = 0;
+
+    virtual_hid_device_service::client_options options;
+    options.server_socket_file_path = socket_file_path;
+    auto c = std::make_unique<virtual_hid_device_service::client>(options);
+    c->connected.connect([&] {
+      ++connected_count;
+    });
+
+    auto server = std::make_unique<pqrs::unix_domain_stream::server>(server_dispatcher,
+                                                                      socket_file_path);
+    server->received.connect([&](auto&&, auto&&) {
+      ++received_count;
+    });
+    server->bound.connect([&] {
+      c->async_start();
+    });
+    server->async_start();
+
+    expect(wait(connected_count, 1));
+
+    virtual_hid_device_driver::hid_report::keyboard_input keyboard_input;
+    keyboard_input.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+
+    virtual_hid_device_driver::hid_report::pointing_input pointing_input;
+    pointing_input.x = 10;
+
+    // Count the allocations from `client::async_post_report` to `unix_domain_stream::client::async_send`,
+    // which run in this thread and the dispatcher thread.
+    // The io threads which write and read the frames are not counted.
+    dispatcher_runner r;
+    r.run([] {
+      allocation_counter::marked_thread = true;
+    });
+    allocation_counter::marked_thread = true;
+
+    auto post = [&](size_t n) {
+      for (size_t i = 0; i < n; ++i) {
+        auto expected = received_count + 2;
+
+        c->async_post_report(keyboard_input);
+        c->async_post_report(pointing_input);
+
+        if (!wait(received_count, expected)) {
+          return;
+        }
+
+        // Let the client's io thread return the written buffers to the pool before the next report.
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    };
+
+    post(warm_up_count);
+
+    auto count = allocation_counter::count_marked_thread_allocations([&] {
+      post(report_count);
+    });
+
+    expect(count == 0_ul);
+    expect(received_count == (warm_up_count + report_count) * 2);
+
+    allocation_counter::marked_thread = false;
+    r.run([] {
+      allocation_counter::marked_thread = false;
+    });
+
+    c = nullptr;
+    server = nullptr;
+    server_dispatcher->terminate();
+  };
+}
@@ -0,0 +1,100 @@
+#include <boost/ut.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+
+void run_duplicate_report_filter_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "duplicate_report_filter"_test = [] {
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    duplicate_report_filter filter;
+
+    keyboard_input keyboard_report;
+    keyboard_report.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+
+    pointing_input pointing_report;
+    pointing_report.buttons.insert(1);
+
+    expect(!filter.suppress(keyboard_report));
+    expect(filter.suppress(keyboard_report));
+    expect(!filter.suppress(pointing_report));
+    expect(filter.suppress(pointing_report));
+
+    // Reports are tracked per type.
+
+    expect(!filter.suppress(consumer_input()));
+    expect(filter.suppress(consumer_input()));
+    expect(filter.suppress(keyboard_report));
+
+    // A changed report is posted and becomes the last report.
+
+    expect(!filter.suppress(keyboard_input()));
+    expect(!filter.suppress(keyboard_report));
+    expect(filter.suppress(keyboard_report));
+
+    // clear_keyboard_reports
+
+    filter.clear_keyboard_reports();
+
+    expect(!filter.suppress(keyboard_report));
+    expect(!filter.suppress(consumer_input()));
+    expect(filter.suppress(pointing_report));
+
+    // clear_pointing_reports
+
+    filter.clear_pointing_reports();
+
+    expect(filter.suppress(keyboard_report));
+    expect(!filter.suppress(pointing_report));
+
+    // clear
+
+    filter.clear();
+
+    expect(!filter.suppress(keyboard_report));
+    expect(!filter.suppress(pointing_report));
+  };
+
+  "duplicate_report_filter pointing movement"_test = [] {
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    duplicate_report_filter filter;
+
+    // Equal reports with relative movement are separate movements, and both are posted.
+
+    pointing_input move_report;
+    move_report.x = 10;
+    move_report.y = 250;
+
+    expect(!filter.suppress(move_report));
+    expect(!filter.suppress(move_report));
+
+    pointing_input scroll_report;
+    scroll_report.vertical_wheel = 1;
+
+    expect(!filter.suppress(scroll_report));
+    expect(!filter.suppress(scroll_report));
+
+    // A repeated report without movement is dropped.
+
+    pointing_input button_report;
+    button_report.buttons.insert(1);
+
+    expect(!filter.suppress(button_report));
+    expect(filter.suppress(button_report));
+
+    // The buttons are kept while moving.
+
+    pointing_input drag_report = button_report;
+    drag_report.x = 1;
+
+    expect(!filter.suppress(drag_report));
+    expect(!filter.suppress(drag_report));
+    expect(!filter.suppress(button_report));
+    expect(filter.suppress(button_report));
+  };
+}
@@ -0,0 +1,87 @@
+#include <boost/ut.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+
+void run_report_batch_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "post_report_size"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    expect(post_report_size(request::post_keyboard_input_report).value_or(0) == 67_ul);
+    expect(post_report_size(request::post_consumer_input_report).value_or(0) == 65_ul);
+    expect(post_report_size(request::post_apple_vendor_keyboard_input_report).value_or(0) == 65_ul);
+    expect(post_report_size(request::post_apple_vendor_top_case_input_report).value_or(0) == 65_ul);
+    expect(post_report_size(request::post_generic_desktop_input_report).value_or(0) == 65_ul);
+    expect(post_report_size(request::post_pointing_input_report).value_or(0) == 8_ul);
+    expect(!post_report_size(request::virtual_hid_keyboard_reset).has_value());
+    expect(!post_report_size(request::post_report_batch).has_value());
+  };
+
+  "make_report_batch_buffers"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    {
+      auto buffers = make_report_batch_buffers({}, 1024);
+      expect(buffers.empty());
+    }
+
+    {
+      virtual_hid_device_driver::hid_report::keyboard_input keyboard_input;
+      keyboard_input.keys.insert(4);
+
+      virtual_hid_device_driver::hid_report::pointing_input pointing_input;
+      pointing_input.x = 10;
+
+      std::vector<input_report> reports{
+          keyboard_input,
+          pointing_input,
+          virtual_hid_device_driver::hid_report::keyboard_input(),
+      };
+
+      auto buffers = make_report_batch_buffers(reports, 1024);
+      expect(buffers.size() == 1_ul);
+
+      const auto& buffer = buffers[0];
+      expect(buffer.size() == 3 + (1 + 67) + (1 + 8) + (1 + 67));
+      expect(buffer[2] == static_cast<uint8_t>(request::post_report_batch));
+      expect(buffer[3] == static_cast<uint8_t>(request::post_keyboard_input_report));
+      expect(memcmp(buffer.data() + 4, &keyboard_input, sizeof(keyboard_input)) == 0);
+      expect(buffer[71] == static_cast<uint8_t>(request::post_pointing_input_report));
+      expect(memcmp(buffer.data() + 72, &pointing_input, sizeof(pointing_input)) == 0);
+      expect(buffer[80] == static_cast<uint8_t>(request::post_keyboard_input_report));
+    }
+
+    // Split into several buffers
+
+    {
+      std::vector<input_report> reports(100, virtual_hid_device_driver::hid_report::pointing_input());
+
+      auto buffers = make_report_batch_buffers(reports, 1024);
+
+      // (1024 - 3) / 9 == 113
+      expect(buffers.size() == 1_ul);
+
+      reports.assign(300, virtual_hid_device_driver::hid_report::pointing_input());
+      buffers = make_report_batch_buffers(reports, 1024);
+      expect(buffers.size() == 3_ul);
+      expect(buffers[0].size() == 3 + 113 * 9);
+      expect(buffers[1].size() == 3 + 113 * 9);
+      expect(buffers[2].size() == 3 + 74 * 9);
+    }
+
+    // Too small max_message_size
+
+    {
+      std::vector<input_report> reports{
+          virtual_hid_device_driver::hid_report::keyboard_input(),
+      };
+
+      auto buffers = make_report_batch_buffers(reports, 16);
+      expect(buffers.empty());
+    }
+  };
+}
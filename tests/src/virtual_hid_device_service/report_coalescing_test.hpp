@@ -0,0 +1,137 @@
+#include <boost/ut.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+
+namespace report_coalescing_test {
+template <typename T>
+std::vector<uint8_t> make_payload(const T& report) {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+  auto buffer = make_request_buffer(post_report_request<T>(), report);
+  return std::vector<uint8_t>(std::begin(buffer), std::end(buffer));
+}
+
+template <typename T>
+T get_report(const std::vector<uint8_t>& payload) {
+  T report;
+  memcpy(&report, payload.data() + 3, sizeof(report));
+  return report;
+}
+
+pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input make_pointing_input(uint8_t button,
+                                                                                                      int8_t x,
+                                                                                                      int8_t y) {
+  pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input report;
+  report.buttons.insert(button);
+  report.x = static_cast<uint8_t>(x);
+  report.y = static_cast<uint8_t>(y);
+  return report;
+}
+} // namespace report_coalescing_test
+
+void run_report_coalescing_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "coalesce_post_report pointing_input"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+    using namespace report_coalescing_test;
+
+    // Sum relative values
+
+    {
+      auto queued = make_payload(make_pointing_input(1, 10, -20));
+      auto payload = make_payload(make_pointing_input(1, 5, -5));
+
+      expect(coalesce_post_report(queued, payload));
+
+      auto report = get_report<pointing_input>(queued);
+      expect(report.buttons.exists(1));
+      expect(static_cast<int8_t>(report.x) == 15_i);
+      expect(static_cast<int8_t>(report.y) == -25_i);
+    }
+
+    // Saturate at the int8 range
+
+    {
+      auto queued = make_payload(make_pointing_input(0, 100, -100));
+      auto payload = make_payload(make_pointing_input(0, 100, -100));
+
+      expect(coalesce_post_report(queued, payload));
+
+      auto report = get_report<pointing_input>(queued);
+      expect(static_cast<int8_t>(report.x) == 127_i);
+      expect(static_cast<int8_t>(report.y) == -128_i);
+    }
+
+    // Preserve button transitions
+
+    {
+      auto queued = make_payload(make_pointing_input(0, 10, 10));
+      auto payload = make_payload(make_pointing_input(1, 10, 10));
+      auto original = queued;
+
+      expect(!coalesce_post_report(queued, payload));
+      expect(queued == original);
+    }
+  };
+
+  "coalesce_post_report keyboard_input"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+    using namespace report_coalescing_test;
+
+    keyboard_input report1;
+    report1.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+
+    keyboard_input report2;
+    report2.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+    report2.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_b));
+
+    // Same state
+
+    {
+      auto queued = make_payload(report1);
+      auto payload = make_payload(report1);
+
+      expect(coalesce_post_report(queued, payload));
+      expect(queued == payload);
+    }
+
+    // The key transition would be lost
+
+    {
+      auto queued = make_payload(report1);
+      auto payload = make_payload(report2);
+      auto original = queued;
+
+      expect(!coalesce_post_report(queued, payload));
+      expect(queued == original);
+    }
+  };
+
+  "coalesce_post_report different requests"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+    using namespace report_coalescing_test;
+
+    {
+      auto queued = make_payload(consumer_input());
+      auto payload = make_payload(apple_vendor_keyboard_input());
+
+      expect(!coalesce_post_report(queued, payload));
+    }
+
+    {
+      std::vector<input_report> reports{pointing_input()};
+      auto queued = make_report_batch_buffers(reports, 1024).front();
+      auto payload = queued;
+
+      expect(!coalesce_post_report(queued, payload));
+    }
+  };
+}
@@ -0,0 +1,89 @@
+#include <boost/ut.hpp>
+#include <filesystem>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <unistd.h>
+
+void run_report_journal_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "report_journal"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    auto path = std::filesystem::temp_directory_path() / ("report_journal_test." + std::to_string(getpid()));
+    auto previous_path = report_journal::get_previous_file_path(path);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(previous_path);
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+      auto journal = report_journal::create(path, 4);
+      expect(journal != nullptr);
+
+      for (int i = 0; i < 6; ++i) {
+        virtual_hid_device_driver::hid_report::pointing_input report;
+        report.x = i;
+
+        journal->write(i % 2,
+                       request::post_pointing_input_report,
+                       std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&report), sizeof(report)),
+                       start + std::chrono::milliseconds(i));
+      }
+
+      // The records can be read while the journal is open.
+      auto entries = report_journal::read(path);
+      expect(entries != std::nullopt);
+      expect(entries->size() == 4_ul);
+    }
+
+    // Only the latest records are kept.
+    {
+      auto entries = report_journal::read(path);
+      expect(entries != std::nullopt);
+      expect(entries->size() == 4_ul);
+
+      for (size_t i = 0; i < entries->size(); ++i) {
+        const auto& e = (*entries)[i];
+        expect(e.sequence == i + 3);
+        expect(e.peer_id == (i + 2) % 2);
+        expect(e.request_type == request::post_pointing_input_report);
+        expect(e.payload.size() == sizeof(virtual_hid_device_driver::hid_report::pointing_input));
+
+        virtual_hid_device_driver::hid_report::pointing_input report;
+        std::memcpy(&report, e.payload.data(), sizeof(report));
+        expect(report.x == i + 2);
+
+        expect(std::chrono::nanoseconds(e.timestamp - entries->front().timestamp) == std::chrono::milliseconds(i));
+      }
+    }
+
+    // The previous journal is kept when the journal is created again.
+    {
+      auto journal = report_journal::create(path, 4);
+      expect(journal != nullptr);
+
+      auto entries = report_journal::read(path);
+      expect(entries != std::nullopt);
+      expect(entries->empty());
+
+      auto previous_entries = report_journal::read(previous_path);
+      expect(previous_entries != std::nullopt);
+      expect(previous_entries->size() == 4_ul);
+    }
+
+    // Other files
+    {
+      expect(report_journal::read(path.string() + ".not_found") == std::nullopt);
+
+      std::filesystem::resize_file(previous_path, 10);
+      expect(report_journal::read(previous_path) == std::nullopt);
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(previous_path);
+  };
+}
@@ -0,0 +1,173 @@
+#include <boost/ut.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <thread>
+
+namespace report_ring_test {
+inline std::string make_name() {
+  static int counter = 0;
+  return "/pqrs.vhid.test." + std::to_string(getpid()) + "." + std::to_string(counter++);
+}
+} // namespace report_ring_test
+
+void run_report_ring_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "report_ring"_test = [] {
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    auto producer = report_ring::create(report_ring_test::make_name());
+    expect(producer != nullptr);
+
+    auto consumer = report_ring::open(producer->get_name(), getuid());
+    expect(consumer != nullptr);
+
+    // The doorbell is armed at first.
+
+    pointing_input pointing_report;
+    pointing_report.x = 10;
+    expect(producer->push(pointing_report) == report_ring::push_result::doorbell_required);
+
+    keyboard_input keyboard_report;
+    keyboard_report.keys.insert(type_safe::get(pqrs::hid::usage::keyboard_or_keypad::keyboard_a));
+    expect(producer->push(keyboard_report) == report_ring::push_result::pushed);
+
+    std::vector<std::pair<request, std::vector<uint8_t>>> reports;
+    expect(consumer->drain([&](auto request_type, auto&& report) {
+      reports.emplace_back(request_type, std::vector<uint8_t>(std::begin(report), std::end(report)));
+    }) == report_ring::drain_result::drained);
+
+    expect(reports.size() == 2_ul);
+    expect(reports[0].first == request::post_pointing_input_report);
+    expect(reports[0].second.size() == sizeof(pointing_report));
+    expect(memcmp(reports[0].second.data(), &pointing_report, sizeof(pointing_report)) == 0);
+    expect(reports[1].first == request::post_keyboard_input_report);
+    expect(reports[1].second.size() == sizeof(keyboard_report));
+    expect(memcmp(reports[1].second.data(), &keyboard_report, sizeof(keyboard_report)) == 0);
+
+    // The doorbell is armed again after drain.
+
+    expect(producer->push(pointing_report) == report_ring::push_result::doorbell_required);
+
+    // Full
+
+    for (uint32_t i = 1; i < report_ring::slot_count; ++i) {
+      expect(producer->push(pointing_report) == report_ring::push_result::pushed);
+    }
+    expect(producer->push(pointing_report) == report_ring::push_result::full);
+
+    size_t count = 0;
+    expect(consumer->drain([&](auto, auto&&) {
+      ++count;
+    }) == report_ring::drain_result::drained);
+    expect(count == report_ring::slot_count);
+
+    // handled_message_count
+
+    expect(producer->get_handled_message_count() == 0_ul);
+    consumer->set_handled_message_count(3);
+    expect(producer->get_handled_message_count() == 3_ul);
+  };
+
+  "report_ring pending"_test = [] {
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    auto producer = report_ring::create(report_ring_test::make_name());
+    auto consumer = report_ring::open(producer->get_name(), getuid());
+    expect(producer != nullptr);
+    expect(consumer != nullptr);
+
+    pointing_input report;
+    expect(producer->push(report) == report_ring::push_result::doorbell_required);
+
+    // A report pushed while the ring is drained is not drained in the same call,
+    // and it does not ring the doorbell.
+    size_t count = 0;
+    expect(consumer->drain([&](auto, auto&&) {
+      if (++count == 1) {
+        expect(producer->push(report) == report_ring::push_result::pushed);
+      }
+    }) == report_ring::drain_result::pending);
+    expect(count == 1_ul);
+
+    expect(consumer->drain([&](auto, auto&&) {
+      ++count;
+    }) == report_ring::drain_result::drained);
+    expect(count == 2_ul);
+
+    // The doorbell is armed.
+    expect(producer->push(report) == report_ring::push_result::doorbell_required);
+  };
+
+  "report_ring open"_test = [] {
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    auto producer = report_ring::create(report_ring_test::make_name());
+    expect(producer != nullptr);
+
+    // The owner is not matched.
+    expect(report_ring::open(producer->get_name(), getuid() + 1) == nullptr);
+
+    // Not null-terminated.
+    report_ring::name_t name;
+    std::ranges::fill(name, 'a');
+    name[0] = '/';
+    expect(report_ring::open(name, getuid()) == nullptr);
+
+    // Unlinked
+    producer->unlink();
+    expect(report_ring::open(producer->get_name(), getuid()) == nullptr);
+
+    // The name is too long.
+    expect(report_ring::create("/" + std::string(40, 'a')) == nullptr);
+  };
+
+  "report_ring concurrent"_test = [] {
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    auto producer = report_ring::create(report_ring_test::make_name());
+    auto consumer = report_ring::open(producer->get_name(), getuid());
+    expect(producer != nullptr);
+    expect(consumer != nullptr);
+
+    constexpr uint32_t report_count = 100000;
+
+    std::thread thread([&] {
+      for (uint32_t i = 0; i < report_count;) {
+        pointing_input report;
+        std::memcpy(&report.x, &i, sizeof(uint32_t));
+
+        if (producer->push(report) == report_ring::push_result::full) {
+          std::this_thread::yield();
+          continue;
+        }
+        ++i;
+      }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    while (expected < report_count) {
+      auto result = consumer->drain([&](auto, auto&& report) {
+        uint32_t value;
+        std::memcpy(&value, report.data() + sizeof(buttons), sizeof(value));
+        if (value != expected) {
+          ordered = false;
+        }
+        ++expected;
+      });
+      if (result == report_ring::drain_result::broken) {
+        break;
+      }
+    }
+
+    thread.join();
+
+    expect(ordered);
+    expect(expected == report_count);
+  };
+}
@@ -0,0 +1,63 @@
+#include "allocation_counter.hpp"
+#include <boost/ut.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+
+void run_request_buffer_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "request_buffer"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    {
+      auto buffer = make_request_buffer(request::virtual_hid_keyboard_reset);
+
+      expect(buffer.size() == 3_ul);
+      expect(memcmp(buffer.data(),
+                    &client_protocol_version::embedded_client_protocol_version,
+                    sizeof(client_protocol_version::value_t)) == 0);
+      expect(buffer.data()[2] == static_cast<uint8_t>(request::virtual_hid_keyboard_reset));
+    }
+
+    {
+      virtual_hid_device_driver::hid_report::pointing_input report;
+      report.x = 10;
+      report.y = 20;
+
+      auto buffer = make_request_buffer(request::post_pointing_input_report,
+                                        report);
+
+      expect(buffer.size() == 11_ul);
+      expect(buffer.data()[2] == static_cast<uint8_t>(request::post_pointing_input_report));
+      expect(memcmp(buffer.data() + 3, &report, sizeof(report)) == 0);
+    }
+
+    static_assert(decltype(make_request_buffer(request::post_keyboard_input_report,
+                                               virtual_hid_device_driver::hid_report::keyboard_input()))::buffer_size == 70);
+  };
+
+  "request_buffer allocation"_test = [] {
+    using namespace pqrs::karabiner::driverkit;
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    virtual_hid_device_driver::hid_report::keyboard_input keyboard_input;
+    virtual_hid_device_driver::hid_report::consumer_input consumer_input;
+    virtual_hid_device_driver::hid_report::pointing_input pointing_input;
+    size_t total_size = 0;
+
+    auto count = allocation_counter::count_allocations([&] {
+      for (int i = 0; i < 1000; ++i) {
+        pointing_input.x = static_cast<uint8_t>(i);
+
+        total_size += make_request_buffer(request::post_keyboard_input_report, keyboard_input).size();
+        total_size += make_request_buffer(request::post_consumer_input_report, consumer_input).size();
+        total_size += make_request_buffer(request::post_pointing_input_report, pointing_input).size();
+      }
+    });
+
+    expect(count == 0_ul);
+    expect(total_size == 1000 * (70 + 68 + 11));
+  };
+}
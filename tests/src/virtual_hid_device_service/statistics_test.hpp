@@ -0,0 +1,41 @@
+#include <boost/ut.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+
+void run_statistics_test() {
+  using namespace boost::ut;
+  using namespace boost::ut::literals;
+
+  "statistics"_test = [] {
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    statistics value{};
+    value.received_keyboard_input_reports = 1;
+    value.received_pointing_input_reports = 2;
+    value.forwarded_reports = 3;
+    value.dropped_reports_by_size_error = 4;
+    value.dropped_reports_by_missing_device = 5;
+    value.backend_errors = 6;
+    value.min_forward_latency = 7;
+    value.mean_forward_latency = 8;
+    value.p99_forward_latency = 9;
+
+    auto buffer = make_statistics_response(value);
+    expect(buffer.size() == 1 + sizeof(statistics));
+    expect(buffer[0] == static_cast<uint8_t>(response::statistics));
+
+    auto parsed = parse_statistics_response(buffer);
+    expect(parsed != std::nullopt);
+    expect(*parsed == value);
+
+    // Truncated buffer
+    buffer.pop_back();
+    expect(parse_statistics_response(buffer) == std::nullopt);
+
+    // Other responses
+    std::vector<uint8_t> ready_response{
+        static_cast<uint8_t>(response::virtual_hid_keyboard_ready),
+        1,
+    };
+    expect(parse_statistics_response(ready_response) == std::nullopt);
+  };
+}
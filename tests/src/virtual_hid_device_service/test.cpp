@@ -0,0 +1,24 @@
+#include "client_allocation_test.hpp"
+#include "duplicate_report_filter_test.hpp"
+#include "report_batch_test.hpp"
+#include "report_coalescing_test.hpp"
+#include "report_journal_test.hpp"
+#include "report_ring_test.hpp"
+#include "request_buffer_test.hpp"
+#include "statistics_test.hpp"
+
+int main() {
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  run_client_allocation_test();
+  run_duplicate_report_filter_test();
+  run_report_batch_test();
+  run_report_coalescing_test();
+  run_report_journal_test();
+  run_report_ring_test();
+  run_request_buffer_test();
+  run_statistics_test();
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+  return 0;
+}
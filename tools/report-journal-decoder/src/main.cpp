@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/report_journal.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+std::string_view request_name(pqrs::karabiner::driverkit::virtual_hid_device_service::request request_type) {
+  using request = pqrs::karabiner::driverkit::virtual_hid_device_service::request;
+
+  switch (request_type) {
+    case request::post_keyboard_input_report:
+      return "post_keyboard_input_report";
+    case request::post_consumer_input_report:
+      return "post_consumer_input_report";
+    case request::post_apple_vendor_keyboard_input_report:
+      return "post_apple_vendor_keyboard_input_report";
+    case request::post_apple_vendor_top_case_input_report:
+      return "post_apple_vendor_top_case_input_report";
+    case request::post_generic_desktop_input_report:
+      return "post_generic_desktop_input_report";
+    case request::post_pointing_input_report:
+      return "post_pointing_input_report";
+    default:
+      return "unknown";
+  }
+}
+
+std::string to_hex(const std::vector<uint8_t>& payload) {
+  constexpr std::string_view digits = "0123456789abcdef";
+
+  std::string result;
+  for (auto b : payload) {
+    result += digits[b >> 4];
+    result += digits[b & 0xf];
+  }
+  return result;
+}
+
+// Returns ISO 8601 time in UTC, such as "2026-01-01T00:00:00.123456789Z".
+std::string to_time_string(uint64_t system_timestamp) {
+  auto seconds = static_cast<time_t>(system_timestamp / 1000000000);
+  auto nanoseconds = static_cast<unsigned long>(system_timestamp % 1000000000);
+
+  struct tm tm;
+  gmtime_r(&seconds, &tm);
+
+  char date[32];
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &tm);
+
+  char result[64];
+  snprintf(result, sizeof(result), "%s.%09luZ", date, nanoseconds);
+  return result;
+}
+
+void usage() {
+  std::cerr << "Usage: report-journal-decoder [--json] <journal file>" << std::endl;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  bool json = false;
+  std::string file_path;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view argument(argv[i]);
+    if (argument == "--json") {
+      json = true;
+    } else if (file_path.empty()) {
+      file_path = argument;
+    } else {
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (file_path.empty()) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  auto entries = pqrs::karabiner::driverkit::virtual_hid_device_service::report_journal::read(file_path);
+  if (!entries) {
+    std::cerr << "report-journal-decoder: " << file_path << " is not a report journal" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (json) {
+    auto array = nlohmann::json::array();
+    for (const auto& e : *entries) {
+      array.push_back({
+          {"sequence", e.sequence},
+          {"timestamp", e.timestamp},
+          {"time", to_time_string(e.system_timestamp)},
+          {"peer_id", e.peer_id},
+          {"request", request_name(e.request_type)},
+          {"payload", to_hex(e.payload)},
+      });
+    }
+    std::cout << array.dump(2) << std::endl;
+  } else {
+    for (const auto& e : *entries) {
+      std::cout << e.sequence << " "
+                << to_time_string(e.system_timestamp) << " "
+                << "peer_id:" << e.peer_id << " "
+                << request_name(e.request_type) << " "
+                << to_hex(e.payload)
+                << std::endl;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <trace_log.hpp>
+#include <utility>
+
+namespace {
+// Returns ISO 8601 time in UTC, such as "2026-01-01T00:00:00.123456789Z".
+std::string to_time_string(uint64_t system_timestamp) {
+  auto seconds = static_cast<time_t>(system_timestamp / 1000000000);
+  auto nanoseconds = static_cast<unsigned long>(system_timestamp % 1000000000);
+
+  struct tm tm;
+  gmtime_r(&seconds, &tm);
+
+  char date[32];
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &tm);
+
+  char result[64];
+  snprintf(result, sizeof(result), "%s.%09luZ", date, nanoseconds);
+  return result;
+}
+
+// Returns the arguments keyed by the names in the event format. (e.g., "peer_id:{0}")
+nlohmann::json to_json_arguments(const trace_log::entry& e) {
+  auto result = nlohmann::json::object();
+
+  auto index = std::to_underlying(e.event);
+  if (index >= trace_event_definitions.size()) {
+    for (size_t i = 0; i < e.arguments.size(); ++i) {
+      result[std::to_string(i)] = e.arguments[i];
+    }
+    return result;
+  }
+
+  std::string_view f = trace_event_definitions[index].format;
+  while (!f.empty()) {
+    auto end = f.find(' ');
+    auto field = f.substr(0, end);
+    f = (end == std::string_view::npos) ? std::string_view() : f.substr(end + 1);
+
+    auto separator = field.find(":{");
+    if (separator != std::string_view::npos &&
+        separator + 3 < field.size()) {
+      auto argument_index = static_cast<size_t>(field[separator + 2] - '0');
+      if (argument_index < e.arguments.size()) {
+        result[std::string(field.substr(0, separator))] = e.arguments[argument_index];
+      }
+    }
+  }
+
+  return result;
+}
+
+void usage() {
+  std::cerr << "Usage: trace-decoder [--json] <trace file>" << std::endl;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  bool json = false;
+  std::string file_path;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view argument(argv[i]);
+    if (argument == "--json") {
+      json = true;
+    } else if (file_path.empty()) {
+      file_path = argument;
+    } else {
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (file_path.empty()) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  auto entries = trace_log::read(file_path);
+  if (!entries) {
+    std::cerr << "trace-decoder: " << file_path << " is not a trace file" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (json) {
+    auto array = nlohmann::json::array();
+    for (const auto& e : *entries) {
+      auto index = std::to_underlying(e.event);
+      array.push_back({
+          {"timestamp", e.timestamp},
+          {"time", to_time_string(e.system_timestamp)},
+          {"thread", e.thread_index},
+          {"event", index < trace_event_definitions.size() ? std::string(trace_event_definitions[index].name) : "unknown:" + std::to_string(index)},
+          {"arguments", to_json_arguments(e)},
+      });
+    }
+    std::cout << array.dump(2) << std::endl;
+  } else {
+    for (const auto& e : *entries) {
+      std::cout << to_time_string(e.system_timestamp) << " "
+                << "thread:" << e.thread_index << " "
+                << trace_log::format(e)
+                << std::endl;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}